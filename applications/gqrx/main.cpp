@@ -75,6 +75,7 @@ int main(int argc, char *argv[])
         ("conf,c", po::value<std::string>(&conf), "Start with this config file")
         ("edit,e", "Edit the config file before using it")
         ("reset,r", "Reset configuration file")
+        ("profile,p", "Enable GNU Radio performance counters for the profiler")
     ;
 
     po::variables_map vm;
@@ -113,6 +114,17 @@ int main(int argc, char *argv[])
         qDebug() << "No user supplied config file. Using" << cfg_file;
     }
 
+    // performance counters add timing overhead to every work() call, so
+    // they are only enabled on request; must be set before the first block
+    // is created
+    if (vm.count("profile"))
+    {
+        if (qputenv("GR_CONF_PERFCOUNTERS_ON", "True"))
+            qDebug() << "Performance counters enabled";
+        else
+            qDebug() << "Failed to enable performance counters";
+    }
+
     if (vm.count("reset"))
         reset_conf(cfg_file);
     else if (vm.count("edit"))
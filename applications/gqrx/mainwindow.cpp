@@ -22,6 +22,7 @@
  * Boston, MA 02110-1301, USA.
  */
 #include <string>
+#include <string.h>
 #include <vector>
 
 #include <QSettings>
@@ -29,6 +30,8 @@
 #include <QDateTime>
 #include <QDesktopServices>
 #include <QDebug>
+#include <QEventLoop>
+#include <QInputDialog>
 #include <QTimer>
 #include "qtgui/ioconfig.h"
 #include "mainwindow.h"
@@ -46,7 +49,6 @@ MainWindow::MainWindow(const QString cfgfile, bool edit_conf, QWidget *parent) :
     ui(new Ui::MainWindow),
     d_lnb_lo(0),
     d_hw_freq(0),
-    d_fftAvg(0.5),
     d_have_audio(true),
     dec_afsk1200(0)
 {
@@ -67,6 +69,13 @@ MainWindow::MainWindow(const QString cfgfile, bool edit_conf, QWidget *parent) :
 
     d_filter_shape = receiver::FILTER_SHAPE_NORMAL;
 
+    d_dspLoad = 0.0;
+    d_decimLoadBefore = 0.0;
+    d_decimReport = 0;
+
+    /* reuse FFT plans from previous sessions */
+    receiver::load_fft_wisdom(QString("%1/fftw_wisdom").arg(m_cfg_dir).toStdString());
+
     /* create receiver object */
     rx = new receiver("", "");
     rx->set_rf_freq(144500000.0f);
@@ -75,19 +84,21 @@ MainWindow::MainWindow(const QString cfgfile, bool edit_conf, QWidget *parent) :
     meter_timer = new QTimer(this);
     connect(meter_timer, SIGNAL(timeout()), this, SLOT(meterTimeout()));
 
-    /* FFT timer & data */
-    iq_fft_timer = new QTimer(this);
-    connect(iq_fft_timer, SIGNAL(timeout()), this, SLOT(iqFftTimeout()));
+    /* profiler timer */
+    profiler_timer = new QTimer(this);
+    connect(profiler_timer, SIGNAL(timeout()), this, SLOT(profilerTimeout()));
+
+    /* FFT producer thread, audio FFT timer & data */
+    iq_fft_producer = new SpectrumProducer(rx, this);
+    connect(iq_fft_producer, SIGNAL(newFrame()), this, SLOT(iqFftFrameReady()),
+            Qt::QueuedConnection);
 
     audio_fft_timer = new QTimer(this);
     connect(audio_fft_timer, SIGNAL(timeout()), this, SLOT(audioFftTimeout()));
 
-    d_fftData = new std::complex<float>[MAX_FFT_SIZE];
-    d_realFftData = new double[MAX_FFT_SIZE];
-    d_pwrFftData = new double[MAX_FFT_SIZE]();
-    d_iirFftData = new double[MAX_FFT_SIZE];
-    for (int i = 0; i < MAX_FFT_SIZE; i++)
-        d_iirFftData[i] = -120.0;  // dBFS
+    d_realFftData = new float[MAX_FFT_SIZE];
+    d_iirFftData = new float[MAX_FFT_SIZE];
+    d_audioFftData = new float[MAX_FFT_SIZE];
 
     /* timer for data decoders */
     dec_timer = new QTimer(this);
@@ -99,6 +110,7 @@ MainWindow::MainWindow(const QString cfgfile, bool edit_conf, QWidget *parent) :
     uiDockInputCtl = new DockInputCtl();
     //uiDockIqPlay = new DockIqPlayer();
     uiDockFft = new DockFft();
+    uiDockProfiler = new DockProfiler();
 
     /* Add dock widgets to main window. This should be done even for
        dock widgets that are going to be hidden, otherwise they will
@@ -114,12 +126,14 @@ MainWindow::MainWindow(const QString cfgfile, bool edit_conf, QWidget *parent) :
     tabifyDockWidget(uiDockFft, uiDockAudio);
 
     //addDockWidget(Qt::BottomDockWidgetArea, uiDockIqPlay);
+    addDockWidget(Qt::BottomDockWidgetArea, uiDockProfiler);
 
     /* hide docks that we don't want to show initially */
     /** FIXME: Hide them initially but store layout in config **/
     //    uiDockInputCtl->hide();
     //    uiDockFft->hide();
     //uiDockIqPlay->hide();
+    uiDockProfiler->hide();
 
     /* misc configurations */
     //uiDockAudio->setFftRange(0, 8000); // FM
@@ -132,6 +146,7 @@ MainWindow::MainWindow(const QString cfgfile, bool edit_conf, QWidget *parent) :
     ui->menu_View->addAction(uiDockAudio->toggleViewAction());
     ui->menu_View->addAction(uiDockFft->toggleViewAction());
     //ui->menu_View->addAction(uiDockIqPlay->toggleViewAction());
+    ui->menu_View->addAction(uiDockProfiler->toggleViewAction());
     ui->menu_View->addSeparator();
     ui->menu_View->addAction(ui->mainToolBar->toggleViewAction());
     ui->menu_View->addSeparator();
@@ -170,6 +185,7 @@ MainWindow::MainWindow(const QString cfgfile, bool edit_conf, QWidget *parent) :
     connect(uiDockFft, SIGNAL(fftRateChanged(int)), this, SLOT(setIqFftRate(int)));
     connect(uiDockFft, SIGNAL(fftSplitChanged(int)), this, SLOT(setIqFftSplit(int)));
     connect(uiDockFft, SIGNAL(fftAvgChanged(double)), this, SLOT(setIqFftAvg(double)));
+    connect(uiDockFft, SIGNAL(fftWelchChanged(bool,double)), this, SLOT(setIqFftWelch(bool,double)));
     connect(uiDockFft, SIGNAL(resetFftZoom()), ui->plotter, SLOT(resetHorizontalZoom()));
     connect(uiDockFft, SIGNAL(gotoFftCenter()), ui->plotter, SLOT(moveToCenterFreq()));
     connect(uiDockFft, SIGNAL(gotoDemodFreq()), ui->plotter, SLOT(moveToDemodFreq()));
@@ -220,8 +236,11 @@ MainWindow::~MainWindow()
     meter_timer->stop();
     delete meter_timer;
 
-    iq_fft_timer->stop();
-    delete iq_fft_timer;
+    profiler_timer->stop();
+    delete profiler_timer;
+
+    iq_fft_producer->stop();
+    delete iq_fft_producer;
 
     audio_fft_timer->stop();
     delete audio_fft_timer;
@@ -249,12 +268,15 @@ MainWindow::~MainWindow()
     delete uiDockAudio;
     delete uiDockFft;
     //delete uiDockIqPlay;
+    delete uiDockProfiler;
     delete uiDockInputCtl;
     delete rx;
-    delete [] d_fftData;
+
+    if (QDir().mkpath(m_cfg_dir))
+        receiver::save_fft_wisdom(QString("%1/fftw_wisdom").arg(m_cfg_dir).toStdString());
     delete [] d_realFftData;
     delete [] d_iirFftData;
-    delete [] d_pwrFftData;
+    delete [] d_audioFftData;
 
     delete _restoreAction;
     delete _quitAction;
@@ -411,9 +433,23 @@ bool MainWindow::loadConfig(const QString cfgfile, bool check_crash)
 
     QString indev = m_settings->value("input/device", "").toString();
     if (!indev.isEmpty())
+    {
+        // open the device while the old one keeps streaming
+        rx->prepare_input_device(indev.toStdString());
+        waitForReceiver();
+    }
+    if (!indev.isEmpty() &&
+        (rx->set_input_device(indev.toStdString()) != receiver::STATUS_OK))
+    {
+        // the receiver keeps using the old device
+        QMessageBox::warning(this, tr("Gqrx error"),
+                             tr("Could not open the input device:\n%1\n"
+                                "The previous device is still in use.").arg(indev),
+                             QMessageBox::Ok, QMessageBox::Ok);
+    }
+    else if (!indev.isEmpty())
     {
         conf_ok = true;
-        rx->set_input_device(indev.toStdString());
 
         // Update window title
         QRegExp regexp("'([a-zA-Z0-9 \\-\\_\\/\\.\\,\\(\\)]+)'");
@@ -439,14 +475,37 @@ bool MainWindow::loadConfig(const QString cfgfile, bool check_crash)
     int sr = m_settings->value("input/sample_rate", 0).toInt(&conv_ok);
     if (conv_ok && (sr > 0))
     {
+        rx->prepare_input_rate(sr);
+        waitForReceiver();
         double actual_rate = rx->set_input_rate(sr);
         qDebug() << "Requested sample rate:" << sr;
         qDebug() << "Actual sample rate   :" << QString("%1").arg(actual_rate, 0, 'f', 6);
-        uiDockRxOpt->setFilterOffsetRange((qint64)(0.9*actual_rate));
-        ui->plotter->setSampleRate(actual_rate);
-        ui->plotter->setSpanFreq((quint32)actual_rate);
     }
 
+    int decim = m_settings->value("input/decimation", 1).toInt(&conv_ok);
+    int old_decim = (int) rx->get_input_decim();
+    if (!conv_ok || (decim < 1))
+        decim = 1;
+    decim = rx->set_input_decim(decim);
+    pruneChannels();
+
+    double quad_rate = rx->get_quad_rate();
+    if (decim > 1)
+        ui->statusBar->showMessage(tr("Input decimation %1: processing %2 ksps instead of %3 ksps")
+                                   .arg(decim)
+                                   .arg(1.e-3 * quad_rate, 0, 'f', 1)
+                                   .arg(1.e-3 * rx->get_input_rate(), 0, 'f', 1), 5000);
+
+    // compare the measured DSP load before and after, see profilerTimeout()
+    if ((decim != old_decim) && (d_dspLoad > 0.0))
+    {
+        d_decimLoadBefore = d_dspLoad;
+        d_decimReport = 2;
+    }
+    uiDockRxOpt->setFilterOffsetRange((qint64)(0.9*quad_rate));
+    ui->plotter->setSampleRate(quad_rate);
+    ui->plotter->setSpanFreq((quint32)quad_rate);
+
     qint64 bw = m_settings->value("input/bandwidth", 0).toInt(&conv_ok);
     if (conv_ok)
     {
@@ -798,7 +857,7 @@ void MainWindow::selectDemod(int index)
         /* Broadcast FM */
     case DockRxOpt::MODE_WFM_MONO:
     case DockRxOpt::MODE_WFM_STEREO:
-        quad_rate = rx->get_input_rate();
+        quad_rate = rx->get_quad_rate();
         if (quad_rate < 200.0e3)
             ui->plotter->setDemodRanges(-0.9*quad_rate/2.0, -10000,
                                         10000, 0.9*quad_rate/2.0,
@@ -1117,70 +1176,78 @@ void MainWindow::meterTimeout()
     ui->sMeter->setLevel(level);
 }
 
-/*! \brief Baseband FFT plot timeout. */
-void MainWindow::iqFftTimeout()
+/*! \brief Profiler timeout.
+ *
+ * Measure the total DSP load and report it after an input decimation
+ * change. Update the profiler dock if it is visible or recording to a CSV
+ * file.
+ */
+void MainWindow::profilerTimeout()
 {
-    unsigned int fftsize;
-    unsigned int i;
-    double gain;
-    double pwr;
-    std::complex<float> pt;             /* a single FFT point used in calculations */
-    std::complex<float> scaleFactor;    /* normalizing factor (fftsize cast to complex) */
+    std::vector<receiver::block_perf> perf;
+    QVector<ProfilerRow> rows;
 
+    d_dspLoad = rx->get_dsp_load();
 
-    rx->get_iq_fft_data(d_fftData, fftsize);
-
-    if (fftsize == 0)
+    // the first interval after the change also contains the reconfiguration
+    if ((d_decimReport > 0) && (--d_decimReport == 0) && (d_dspLoad > 0.0))
     {
-        /* nothing to do, wait until next activation. */
-        return;
+        ui->statusBar->showMessage(tr("Input decimation %1: DSP load %2% before, %3% after (100% is one core)")
+                                   .arg(rx->get_input_decim())
+                                   .arg(100.0 * d_decimLoadBefore, 0, 'f', 1)
+                                   .arg(100.0 * d_dspLoad, 0, 'f', 1), 10000);
+        qDebug() << "Input decimation" << rx->get_input_decim() << "DSP load"
+                 << d_decimLoadBefore << "->" << d_dspLoad;
     }
 
-    scaleFactor = std::complex<float>((float)fftsize);
+    if (uiDockProfiler->isHidden() && !uiDockProfiler->isRecording())
+        return;
 
-    /** FIXME: move post processing to rx_fft_c **/
-    /* Normalize, calculcate power and shift the FFT */
-    for (i = 0; i < fftsize; i++)
+    rx->get_block_perf(perf);
+    rows.resize((int) perf.size());
+    for (unsigned int i = 0; i < perf.size(); i++)
     {
+        rows[i].name = QString::fromStdString(perf[i].name);
+        rows[i].workTime = perf[i].work_time;
+        rows[i].busy = perf[i].busy;
+        rows[i].throughput = perf[i].throughput;
+        rows[i].inFull = perf[i].in_full;
+        rows[i].outFull = perf[i].out_full;
+    }
 
-        /* normalize and shift */
-        if (i < fftsize/2)
-        {
-            pt = d_fftData[fftsize/2+i] / scaleFactor;
-        }
-        else
-        {
-            pt = d_fftData[i-fftsize/2] / scaleFactor;
-        }
-        pwr = pt.imag()*pt.imag() + pt.real()*pt.real();
-
-        /* calculate power in dBFS */
-        d_realFftData[i] = 10.0 * log10(pwr + 1.0e-20);
-
-        /* FFT averaging (aka. video filter) */
-        gain = d_fftAvg * (150.0+d_realFftData[i])/150.0;
-        //gain = 0.1;
+    uiDockProfiler->setRows(rows);
+    uiDockProfiler->setMailboxStats(param_mailbox_stats::updates(),
+                                    param_mailbox_stats::overwritten(),
+                                    param_mailbox_stats::contention());
+}
 
-        d_iirFftData[i] = (1.0 - gain) * d_iirFftData[i] + gain * d_realFftData[i];
+/*! \brief New baseband FFT frame from the producer thread.
+ *
+ * The frame is copied so that the plotter can keep using it after the
+ * producer has moved on.
+ */
+void MainWindow::iqFftFrameReady()
+{
+    if (!iq_fft_producer->fetch())
+        return;
 
-    }
+    const spectrum_frame &frame = iq_fft_producer->frame();
 
-    ui->plotter->setNewFttData(d_iirFftData, d_realFftData, fftsize);
+    memcpy(d_iirFftData, &frame.fft[0], sizeof(float) * frame.size);
+    memcpy(d_realFftData, &frame.wf[0], sizeof(float) * frame.size);
 
+    ui->plotter->setNewFttData(d_iirFftData, d_realFftData, frame.size);
 }
 
 /*! \brief Audio FFT plot timeout. */
 void MainWindow::audioFftTimeout()
 {
     unsigned int fftsize;
-    unsigned int i;
-    std::complex<float> pt;             /* a single FFT point used in calculations */
-    std::complex<float> scaleFactor;    /* normalizing factor (fftsize cast to complex) */
 
     if (!d_have_audio)
         return;
 
-    rx->get_audio_fft_data(d_fftData, fftsize);
+    rx->get_audio_fft_data(d_audioFftData, fftsize);
 
     if (fftsize == 0)
     {
@@ -1189,27 +1256,7 @@ void MainWindow::audioFftTimeout()
         return;
     }
 
-    scaleFactor = std::complex<float>((float)fftsize);
-
-    /** FIXME: move post processing to rx_fft_f **/
-    /* Normalize, calculcate power and shift the FFT */
-    for (i = 0; i < fftsize; i++)
-    {
-        /* normalize and shift */
-        if (i < fftsize/2)
-        {
-            pt = d_fftData[fftsize/2+i] / scaleFactor;
-        }
-        else
-        {
-            pt = d_fftData[i-fftsize/2] / scaleFactor;
-        }
-
-        /* calculate power in dBFS */
-        d_realFftData[i] = 10.0 * log10(pt.imag()*pt.imag() + pt.real()*pt.real() + 1.0e-20);
-    }
-
-    uiDockAudio->setNewFttData(d_realFftData, fftsize);
+    uiDockAudio->setNewFttData(d_audioFftData, fftsize);
 }
 
 
@@ -1332,23 +1379,20 @@ void MainWindow::setIqFftSize(int size)
 /*! \brief Baseband FFT rate has changed. */
 void MainWindow::setIqFftRate(int fps)
 {
-    int interval;
+    rx->set_iq_fft_rate(fps);
 
     if (fps == 0)
     {
-        interval = 36e7; // 100 hours
         ui->plotter->setRunningState(false);
     }
     else
     {
-        interval = 1000 / fps;
-
-        if (iq_fft_timer->isActive())
+        if (iq_fft_producer->isRunning())
             ui->plotter->setRunningState(true);
     }
 
-    if (interval > 9 && iq_fft_timer->isActive())
-        iq_fft_timer->setInterval(interval);
+    if (fps == 0 || 1000 / fps > 9)
+        iq_fft_producer->setRate(fps);
 }
 
 /*! \brief Vertical split between waterfall and pandapter changed.
@@ -1365,7 +1409,13 @@ void MainWindow::setIqFftSplit(int pct_wf)
 void MainWindow::setIqFftAvg(double avg)
 {
     if ((avg >= 0) && (avg <= 1.0))
-        d_fftAvg = avg;
+        rx->set_iq_fft_avg(avg);
+}
+
+/*! \brief Baseband FFT Welch mode or overlap changed. */
+void MainWindow::setIqFftWelch(bool enable, double overlap)
+{
+    rx->set_iq_fft_welch(enable, overlap);
 }
 
 /*! \brief Audio FFT rate has changed. */
@@ -1408,6 +1458,13 @@ void MainWindow::setFftFill(bool enable)
  */
 void MainWindow::forceRxReconf()
 {
+    // runs from a timer, also while waitForReceiver() is waiting
+    if (!rx->is_input_prepared())
+    {
+        QTimer::singleShot(100, this, SLOT(forceRxReconf()));
+        return;
+    }
+
     qDebug() << "Force RX reconf (jerky dongle workarond)...";
     selectDemod(uiDockRxOpt->currentDemod());
 }
@@ -1427,17 +1484,11 @@ void MainWindow::on_actionDSP_triggered(bool checked)
 
         /* start GUI timers */
         meter_timer->start(100);
+        profiler_timer->start(1000);
 
-        if (uiDockFft->fftRate())
-        {
-            iq_fft_timer->start(1000/uiDockFft->fftRate());
-            ui->plotter->setRunningState(true);
-        }
-        else
-        {
-            iq_fft_timer->start(36e7); // 100 hours
-            ui->plotter->setRunningState(false);
-        }
+        iq_fft_producer->setRate(uiDockFft->fftRate());
+        iq_fft_producer->start();
+        ui->plotter->setRunningState(uiDockFft->fftRate() != 0);
 
         audio_fft_timer->start(100);
 
@@ -1452,7 +1503,10 @@ void MainWindow::on_actionDSP_triggered(bool checked)
     {
         /* stop GUI timers */
         meter_timer->stop();
-        iq_fft_timer->stop();
+        profiler_timer->stop();
+        d_dspLoad = 0.0;
+        d_decimReport = 0;
+        iq_fft_producer->stop();
         audio_fft_timer->stop();
 
         /* stop receiver */
@@ -1482,16 +1536,14 @@ int MainWindow::on_actionIoConfig_triggered()
 
     if (confres == QDialog::Accepted)
     {
-        if (ui->actionDSP->isChecked())
-            // suspend DSP while we reload settings
-            on_actionDSP_triggered(false);
-
+        // the receiver swaps device and sample rate while running
         storeSession();
+        rx->reset_reconf_time();
         loadConfig(m_settings->fileName(), false);
 
         if (ui->actionDSP->isChecked())
-            // restsart DSP
-            on_actionDSP_triggered(true);
+            ui->statusBar->showMessage(tr("Input reconfigured in %1 ms")
+                                       .arg(rx->get_reconf_time(), 0, 'f', 1), 5000);
     }
 
     delete ioconf;
@@ -1697,6 +1749,139 @@ void MainWindow::on_actionAFSK1200_triggered()
 }
 
 
+/*! \brief Channelizer mode toggled.
+ *  \param checked Whether new channels are fed from the channelizer.
+ *
+ * Switching the channelizer off removes all channels attached to it.
+ */
+void MainWindow::on_actionChannelizer_triggered(bool checked)
+{
+    if (checked)
+    {
+        bool ok;
+        double spacing = QInputDialog::getDouble(this, tr("Channelizer"),
+                                                 tr("Channel spacing (kHz)"),
+                                                 12.5, 1.0, 1000.0, 3, &ok);
+
+        if (!ok || rx->start_channelizer(1000.0 * spacing) != receiver::STATUS_OK)
+        {
+            ui->actionChannelizer->setChecked(false);
+            if (ok)
+                ui->statusBar->showMessage(tr("Error starting channelizer"), 5000);
+            return;
+        }
+
+        ui->statusBar->showMessage(tr("Channelizer: %1 kHz spacing")
+                                   .arg(1.e-3 * rx->get_channelizer_spacing(), 0, 'f', 3), 5000);
+    }
+    else
+    {
+        rx->stop_channelizer();
+        pruneChannels();
+    }
+}
+
+/*! \brief Add an extra channel at the current filter position.
+ *
+ * The channel uses the current demodulator and filter and records its
+ * audio to a WAV file in the audio recording directory. The main receiver
+ * stays where it is and can be tuned to the next channel. In channelizer
+ * mode the channel is attached to the closest channelizer output.
+ */
+void MainWindow::on_actionAddChannel_triggered()
+{
+    receiver::rx_demod demod = rx->get_demod();
+    double offset = rx->get_filter_offset();
+    qint64 freq = (qint64)(rx->get_rf_freq() + offset) + d_lnb_lo;
+    int flo, fhi;
+    int id;
+
+    if (demod == receiver::RX_DEMOD_OFF)
+    {
+        ui->statusBar->showMessage(tr("Select a demodulator before adding a channel"), 5000);
+        return;
+    }
+
+    QString file_name = QDateTime::currentDateTime().toUTC().toString("gqrx-yyyyMMdd-hhmmss");
+    file_name = QString("%1/%2-%3.wav").arg(uiDockAudio->recDir()).arg(file_name).arg(freq);
+
+    if (rx->is_channelizer_active())
+        id = rx->add_channelizer_channel(rx->get_channelizer_index(offset), demod,
+                                         file_name.toStdString());
+    else
+        id = rx->add_channel(offset, demod, file_name.toStdString());
+    if (id < 0)
+    {
+        ui->statusBar->showMessage(tr("Error adding channel"), 5000);
+        return;
+    }
+
+    ui->plotter->getHiLowCutFrequencies(&flo, &fhi);
+    rx->set_channel_filter(id, (double) flo, (double) fhi, d_filter_shape);
+
+    d_channels.append(id);
+    ui->actionRemoveChannels->setEnabled(true);
+    ui->statusBar->showMessage(tr("Channel %1 at %2 kHz recording to %3")
+                               .arg(id).arg(freq / 1000.0, 0, 'f', 3)
+                               .arg(file_name));
+}
+
+/*! \brief Wait for the receiver to prepare an input change.
+ *
+ * The window keeps repainting and the timers keep running, but user input
+ * and remote control commands are held back so that the receiver is not
+ * reconfigured while its worker prepares the change.
+ */
+void MainWindow::waitForReceiver()
+{
+    QEventLoop loop;
+    QTimer     poll;
+
+    connect(&poll, SIGNAL(timeout()), &loop, SLOT(quit()));
+    poll.start(20);
+
+    while (!rx->is_input_prepared())
+        loop.exec(QEventLoop::ExcludeUserInputEvents | QEventLoop::ExcludeSocketNotifiers);
+}
+
+/*! \brief Forget channels the receiver has removed.
+ *
+ * The receiver removes channelizer channels when the channelizer is
+ * stopped or when they fall outside the band after a rate change.
+ */
+void MainWindow::pruneChannels()
+{
+    int lost = 0;
+
+    for (int i = d_channels.size() - 1; i >= 0; i--)
+    {
+        if (!rx->has_channel(d_channels.at(i)))
+        {
+            d_channels.removeAt(i);
+            lost++;
+        }
+    }
+
+    ui->actionRemoveChannels->setEnabled(!d_channels.isEmpty());
+    if (lost > 0)
+        ui->statusBar->showMessage(tr("%1 channels removed").arg(lost), 5000);
+
+    if (!rx->is_channelizer_active())
+        ui->actionChannelizer->setChecked(false);
+}
+
+/*! \brief Remove all extra channels and close their WAV files. */
+void MainWindow::on_actionRemoveChannels_triggered()
+{
+    for (int i = 0; i < d_channels.size(); i++)
+        rx->remove_channel(d_channels.at(i));
+
+    d_channels.clear();
+    ui->actionRemoveChannels->setEnabled(false);
+    ui->statusBar->showMessage(tr("All channels removed"), 5000);
+}
+
+
 /*! \brief Destroy AFSK1200 decoder window got closed.
  *
  * This slot is connected to the windowClosed() signal of the AFSK1200 decoder
@@ -40,12 +40,14 @@
 #include "qtgui/dockinputctl.h"
 #include "qtgui/dockiqplayer.h"
 #include "qtgui/dockfft.h"
+#include "qtgui/dockprofiler.h"
 #include "qtgui/afsk1200win.h"
 
 // see https://bugreports.qt-project.org/browse/QTBUG-22829
 #ifndef Q_MOC_RUN
 #include "applications/gqrx/receiver.h"
 #endif
+#include "applications/gqrx/spectrum_producer.h"
 
 namespace Ui {
     class MainWindow;  /*! The main window UI */
@@ -82,12 +84,9 @@ private:
     qint64 d_hw_freq;
 
     enum receiver::filter_shape d_filter_shape;
-    std::complex<float>* d_fftData;
-    double *d_realFftData; /** FIXME: use vector */
-    double *d_iirFftData;  /** FIXME: use vector */
-    double *d_pwrFftData;  /** FIXME: use vector */
-    //double *d_audioFttData;
-    double  d_fftAvg;      /*!< FFT averaging parameter set by user (not the true gain). */
+    float *d_realFftData;  /*!< Baseband power spectrum (waterfall). FIXME: use vector */
+    float *d_iirFftData;   /*!< Averaged baseband power spectrum (pandapter). FIXME: use vector */
+    float *d_audioFftData; /*!< Audio power spectrum. FIXME: use vector */
 
     bool d_have_audio;  /*!< Whether we have audio (i.e. not with demod_off. */
 
@@ -97,17 +96,25 @@ private:
     DockInputCtl   *uiDockInputCtl;
     //DockIqPlayer   *uiDockIqPlay;
     DockFft        *uiDockFft;
+    DockProfiler   *uiDockProfiler;
 
     /* data decoders */
     Afsk1200Win    *dec_afsk1200;
 
     QTimer   *dec_timer;
     QTimer   *meter_timer;
-    QTimer   *iq_fft_timer;
+    QTimer   *profiler_timer;
+    SpectrumProducer *iq_fft_producer;
     QTimer   *audio_fft_timer;
 
     receiver *rx;
 
+    QList<int> d_channels;  /*!< IDs of the additional receiver channels. */
+
+    double d_dspLoad;         /*!< DSP load at the last profiler update, 0 if unknown. */
+    double d_decimLoadBefore; /*!< DSP load before the last decimation change. */
+    int    d_decimReport;     /*!< Profiler updates until the decimation report, 0 if none. */
+
     //systray icon
     QMenu *_trayIconMenu;
     QAction *_restoreAction;
@@ -117,6 +124,8 @@ private:
 private:
     void updateFrequencyRange(bool ignore_limits);
     void updateGainStages();
+    void pruneChannels();
+    void waitForReceiver();
 
     // systray icon
     void createActions();
@@ -164,6 +173,7 @@ private slots:
     void setIqFftRate(int fps);
     void setIqFftSplit(int pct_wf);
     void setIqFftAvg(double avg);
+    void setIqFftWelch(bool enable, double overlap);
     void setAudioFftRate(int fps);
     void setFftColor(const QColor color);
     void setFftFill(bool enable);
@@ -180,6 +190,9 @@ private slots:
     void on_actionIqRec_triggered(bool checked);
     void on_actionFullScreen_triggered(bool checked);
     void on_actionAFSK1200_triggered();
+    void on_actionChannelizer_triggered(bool checked);
+    void on_actionAddChannel_triggered();
+    void on_actionRemoveChannels_triggered();
     void on_actionUserGroup_triggered();
     void on_actionAbout_triggered();
     void on_actionAboutQt_triggered();
@@ -194,7 +207,8 @@ private slots:
     /* cyclic processing */
     void decoderTimeout();
     void meterTimeout();
-    void iqFftTimeout();
+    void profilerTimeout();
+    void iqFftFrameReady();
     void audioFftTimeout();
 
     /* tray icon raises window */
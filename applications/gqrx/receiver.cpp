@@ -24,14 +24,19 @@
 #include <iostream>
 #include <unistd.h>
 
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/thread.hpp>
+#include <gnuradio/block_detail.h>
 #include <gnuradio/prefs.h>
 #include <gnuradio/top_block.h>
 #include <gnuradio/blocks/multiply_const_ff.h>
+#include <gnuradio/filter/firdes.h>
 #include <osmosdr/source.h>
 #include <osmosdr/ranges.h>
 
 #include "applications/gqrx/receiver.h"
-#include "dsp/correct_iq_cc.h"
+#include "dsp/iq_condition_cc.h"
+#include "dsp/fft_plan_cache.h"
 #include "dsp/rx_fft.h"
 #include "receivers/nbrx.h"
 #include "receivers/wfmrx.h"
@@ -43,6 +48,35 @@
 #endif
 
 
+/*! \brief Get the time elapsed since a flow graph reconfiguration started.
+ *  \param t0 The time just before the flow graph was locked.
+ *  \return The elapsed time in milliseconds.
+ */
+static double reconf_time_ms(const boost::posix_time::ptime &t0)
+{
+    boost::posix_time::time_duration dt =
+            boost::posix_time::microsec_clock::universal_time() - t0;
+    double ms = dt.total_microseconds() / 1000.0;
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    std::cout << "Flow graph reconfigured in " << ms << " ms" << std::endl;
+#endif
+
+    return ms;
+}
+
+/*! \brief Largest value of a per-port buffer fullness vector, -1 if empty. */
+static float max_fullness(const std::vector<float> &full)
+{
+    float max = -1.0f;
+
+    for (unsigned int i = 0; i < full.size(); i++)
+        if (full[i] > max)
+            max = full[i];
+
+    return max;
+}
+
 /*! \brief Public contructor.
  *  \param input_device Input device specifier.
  *  \param audio_device Audio output device specifier,
@@ -53,14 +87,25 @@
 receiver::receiver(const std::string input_device, const std::string audio_device)
     : d_running(false),
       d_input_rate(96000.0),
+      d_quad_rate(96000.0),
+      d_decim(1),
       d_audio_rate(48000),
       d_rf_freq(144800000.0),
       d_filter_offset(0.0),
+      d_iq_fft_rate(15),
       d_recording_wav(false),
       d_sniffer_active(false),
       d_iq_rev(false),
       d_dc_cancel(false),
       d_iq_balance(false),
+      d_next_channel_id(1),
+      d_reconf_time(0.0),
+      d_load_time(0),
+      d_pfb_nchans(0),
+      d_pfb_spacing(0.0),
+      d_prep_busy(false),
+      d_prep_rate(0.0),
+      d_prep_actual_rate(0.0),
       d_demod(RX_DEMOD_OFF)
 {
 
@@ -78,12 +123,11 @@ receiver::receiver(const std::string input_device, const std::string audio_devic
     }
 
     rx = make_nbrx(d_input_rate, d_audio_rate);
-    lo = gr::analog::sig_source_c::make(d_input_rate, gr::analog::GR_SIN_WAVE, 0.0, 1.0);
-    mixer = gr::blocks::multiply_cc::make();
+    rotator = make_rx_rotator_cc(d_input_rate, 0.0);
 
-    iq_swap = make_iq_swap_cc(false);
-    dc_corr = make_dc_corr_cc(d_input_rate, 1.0);
+    iq_cond = make_iq_condition_cc(d_input_rate, 1.0);
     iq_fft = make_rx_fft_c(4096u, 0);
+    update_iq_fft_period();
 
     audio_fft = make_rx_fft_f(3072u);
     audio_gain0 = gr::blocks::multiply_const_ff::make(0.1);
@@ -117,11 +161,31 @@ receiver::receiver(const std::string input_device, const std::string audio_devic
 /*! \brief Public destructor. */
 receiver::~receiver()
 {
+    wait_input_prepared();
     tb->stop();
 
     /* FIXME: delete blocks? */
 }
 
+/*! \brief Load FFTW wisdom used by the spectrum FFTs.
+ *  \param filename The wisdom file, e.g. in the gqrx config directory.
+ *
+ * Call this before creating the receiver so that the initial FFT plans
+ * can be created from wisdom instead of being measured from scratch.
+ */
+bool receiver::load_fft_wisdom(const std::string filename)
+{
+    return fft_plan_cache::load_wisdom(filename);
+}
+
+/*! \brief Save FFTW wisdom for use in future sessions.
+ *  \param filename The wisdom file, e.g. in the gqrx config directory.
+ */
+bool receiver::save_fft_wisdom(const std::string filename)
+{
+    return fft_plan_cache::save_wisdom(filename);
+}
+
 
 /*! \brief Start the receiver. */
 void receiver::start()
@@ -150,16 +214,192 @@ void receiver::stop()
     }
 }
 
+/*! \brief Settings of an I/Q source that are lost when it is reopened. */
+struct source_settings
+{
+    double      rate;       /*!< Sample rate. */
+    double      freq;       /*!< Center frequency. */
+    double      bandwidth;  /*!< Analog bandwidth. */
+    double      ppm;        /*!< Frequency correction. */
+    bool        auto_gain;  /*!< Hardware AGC. */
+    std::string antenna;    /*!< Antenna connector. */
+    std::vector<std::pair<std::string, double> > gains; /*!< Gain stages. */
+};
+
+/*! \brief Read the settings of a source, see restore_source_settings(). */
+static void save_source_settings(osmosdr::source::sptr src, source_settings &s)
+{
+    std::vector<std::string> names = src->get_gain_names();
+
+    s.rate = src->get_sample_rate();
+    s.freq = src->get_center_freq();
+    s.bandwidth = src->get_bandwidth();
+    s.ppm = src->get_freq_corr();
+    s.auto_gain = src->get_gain_mode();
+    s.antenna = src->get_antenna();
+    s.gains.clear();
+    for (unsigned int i = 0; i < names.size(); i++)
+        s.gains.push_back(std::make_pair(names[i], src->get_gain(names[i])));
+}
+
+/*! \brief Apply settings read by save_source_settings() to a reopened source. */
+static void restore_source_settings(osmosdr::source::sptr src, const source_settings &s)
+{
+    src->set_sample_rate(s.rate);
+    src->set_center_freq(s.freq);
+    src->set_freq_corr(s.ppm);
+    src->set_bandwidth(s.bandwidth);
+    if (!s.antenna.empty())
+        src->set_antenna(s.antenna);
+    src->set_gain_mode(s.auto_gain);
+    if (!s.auto_gain)
+        for (unsigned int i = 0; i < s.gains.size(); i++)
+            src->set_gain(s.gains[i].second, s.gains[i].first);
+}
+
+/*! \brief Open a new input device in the background.
+ *  \param device The device string of the new device.
+ *
+ * The device is opened by a worker thread while the old one keeps
+ * streaming. Once is_input_prepared() returns true, set_input_device()
+ * swaps it in and only the swap runs with the flow graph locked. The
+ * receiver must not be reconfigured until the preparation has finished.
+ */
+void receiver::prepare_input_device(const std::string device)
+{
+    wait_input_prepared();
+
+    /* set_input_device() does nothing in this case */
+    if (device == input_devstr)
+        return;
+
+    boost::mutex::scoped_lock lock(d_prep_mutex);
+
+    d_prep_busy = true;
+    d_prep_src.reset();
+    d_prep_devstr = device;
+    d_prep_rate = 0.0;
+
+    boost::thread worker(&receiver::prepare_device_worker, this, device);
+    worker.detach();
+}
+
+/*! \brief Worker for prepare_input_device(). */
+void receiver::prepare_device_worker(const std::string device)
+{
+    osmosdr::source::sptr new_src;
+
+    try
+    {
+        new_src = osmosdr::source::make(device);
+    }
+    catch (std::exception &e)
+    {
+#ifndef QT_NO_DEBUG_OUTPUT
+        std::cout << "Could not open " << device << " while running: "
+                  << e.what() << std::endl;
+#endif
+    }
+
+    boost::mutex::scoped_lock lock(d_prep_mutex);
+    d_prep_src = new_src;
+    d_prep_busy = false;
+    d_prep_cond.notify_all();
+}
+
+/*! \brief Set a new input rate in the background.
+ *  \param rate The desired input rate.
+ *
+ * A worker thread sets the rate of the device and prepares the rate
+ * dependent filters of the receivers while the flow graph is running.
+ * Once is_input_prepared() returns true, set_input_rate() swaps them in
+ * with the flow graph locked. The receiver must not be reconfigured until
+ * the preparation has finished.
+ */
+void receiver::prepare_input_rate(double rate)
+{
+    wait_input_prepared();
+
+    boost::mutex::scoped_lock lock(d_prep_mutex);
+
+    d_prep_busy = true;
+    d_prep_src.reset();
+    d_prep_devstr.clear();
+    d_prep_rate = rate;
+    d_prep_actual_rate = d_input_rate;
+
+    boost::thread worker(&receiver::prepare_rate_worker, this, rate);
+    worker.detach();
+}
+
+/*! \brief Worker for prepare_input_rate(). */
+void receiver::prepare_rate_worker(double rate)
+{
+    double actual_rate = d_input_rate;
+
+    // don't bother with sub-hertz changes
+    if (fabs(rate - d_input_rate) >= 1.0)
+    {
+        try
+        {
+            actual_rate = src->set_sample_rate(rate);
+
+            double quad_rate = actual_rate / d_decim;
+            rx->prepare_quad_rate(quad_rate);
+            for (unsigned int i = 0; i < d_channels.size(); i++)
+                if (d_channels[i].pfb_index < 0)
+                    d_channels[i].rx->prepare_quad_rate(quad_rate);
+        }
+        catch (std::exception &e)
+        {
+#ifndef QT_NO_DEBUG_OUTPUT
+            std::cout << "Could not set input rate " << rate << ": "
+                      << e.what() << std::endl;
+#endif
+        }
+    }
+
+    boost::mutex::scoped_lock lock(d_prep_mutex);
+    d_prep_actual_rate = actual_rate;
+    d_prep_busy = false;
+    d_prep_cond.notify_all();
+}
+
+/*! \brief Whether the last prepare_input_device() or prepare_input_rate() has finished. */
+bool receiver::is_input_prepared()
+{
+    boost::mutex::scoped_lock lock(d_prep_mutex);
+
+    return !d_prep_busy;
+}
+
+/*! \brief Wait until the running preparation, if any, has finished. */
+void receiver::wait_input_prepared()
+{
+    boost::mutex::scoped_lock lock(d_prep_mutex);
+
+    while (d_prep_busy)
+        d_prep_cond.wait(lock);
+}
+
 /*! \brief Select new input device.
+ *  \return STATUS_ERROR if the new device could not be opened. The old
+ *          device is used in that case.
+ *  \throws std::exception if neither the new nor the old device can be
+ *          opened. The flow graph is stopped and unlocked in that case.
+ *
+ * Uses the source opened by prepare_input_device(), which is called here
+ * and waited for if the caller did not do so. Devices that can not be
+ * opened twice are reopened with the flow graph locked.
  *
  * \bug When using ALSA, program will crash if the new device
  *      is the same as the previously used device:
  *      audio_alsa_source[hw:1]: Device or resource busy
  */
-void receiver::set_input_device(const std::string device)
+receiver::status receiver::set_input_device(const std::string device)
 {
     if (device.empty())
-        return;
+        return STATUS_ERROR;
 
     if (input_devstr.compare(device) == 0)
     {
@@ -168,18 +408,73 @@ void receiver::set_input_device(const std::string device)
                   << "  old: " << input_devstr << std::endl
                   << "  new: " << device << std::endl;
 #endif
-        return;
+        return STATUS_OK;
+    }
+
+    wait_input_prepared();
+    if (d_prep_devstr != device)
+    {
+        prepare_input_device(device);
+        wait_input_prepared();
     }
 
+    osmosdr::source::sptr new_src = d_prep_src;
+    osmosdr::source::sptr old_src = src;
+    std::string old_devstr = input_devstr;
+    source_settings old_settings;
+    status ret = STATUS_OK;
+
+    d_prep_src.reset();
+    d_prep_devstr.clear();
     input_devstr = device;
 
-    tb->lock();
+    boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
 
-    tb->disconnect(src, 0, iq_swap, 0);
-    src.reset();
-    src = osmosdr::source::make(device);
-    tb->connect(src, 0, iq_swap, 0);
+    tb->lock();
+    tb->disconnect(src, 0, iq_cond, 0);
+    if (!new_src)
+    {
+        save_source_settings(old_src, old_settings);
+        src.reset();
+        old_src.reset();
+        try
+        {
+            new_src = osmosdr::source::make(device);
+        }
+        catch (std::exception &e)
+        {
+#ifndef QT_NO_DEBUG_OUTPUT
+            std::cout << "Could not open " << device << ": " << e.what() << std::endl;
+#endif
+            input_devstr = old_devstr;
+            ret = STATUS_ERROR;
+
+            /* go back to the old device with the settings it had */
+            try
+            {
+                new_src = osmosdr::source::make(old_devstr);
+                restore_source_settings(new_src, old_settings);
+            }
+            catch (std::exception &)
+            {
+                /* nothing to connect; leave an empty, unlocked graph */
+                tb->disconnect_all();
+                tb->unlock();
+                stop();
+                throw;
+            }
+        }
+    }
+    src = new_src;
+    tb->connect(src, 0, iq_cond, 0);
     tb->unlock();
+
+    d_reconf_time += reconf_time_ms(t0);
+
+    /* close the old device after the flow graph is running again */
+    old_src.reset();
+
+    return ret;
 }
 
 
@@ -203,6 +498,8 @@ void receiver::set_output_device(const std::string device)
 
     output_devstr = device;
 
+    boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+
     tb->lock();
 
     tb->disconnect(audio_gain0, 0, audio_snk, 0);
@@ -219,6 +516,8 @@ void receiver::set_output_device(const std::string device)
     tb->connect(audio_gain1, 0, audio_snk, 1);
 
     tb->unlock();
+
+    d_reconf_time += reconf_time_ms(t0);
 }
 
 /*! \brief Get a list of available antenna connectors. */
@@ -236,11 +535,26 @@ void receiver::set_antenna(const std::string &antenna)
 /*! \brief Set new input sample rate.
  *  \param rate The desired input rate
  *  \return The actual sample rate set.
+ *
+ * Uses the rate and filters prepared by prepare_input_rate(), which is
+ * called here and waited for if the caller did not do so. An active
+ * channelizer is rebuilt for the new rate. Channelizer channels that fall
+ * outside the new band are removed, see rebuild_channelizer().
  */
 double receiver::set_input_rate(double rate)
 {
-    // don't bother with sub-hertz changes
-    if (fabs(rate-d_input_rate) < 1.0)
+    double actual_rate;
+
+    wait_input_prepared();
+    if (d_prep_rate != rate)
+    {
+        prepare_input_rate(rate);
+        wait_input_prepared();
+    }
+    actual_rate = d_prep_actual_rate;
+    d_prep_rate = 0.0;
+
+    if (fabs(actual_rate - d_input_rate) < 1.0)
     {
 #ifndef QT_NO_DEBUG_OUTPUT
         std::cout << "No siginficant change in input sample rate" << std::endl;
@@ -248,12 +562,36 @@ double receiver::set_input_rate(double rate)
     }
     else
     {
+        /* the device and the receivers were prepared by prepare_input_rate() */
+        d_input_rate = actual_rate;
+        d_quad_rate = d_input_rate / d_decim;
+
+        boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+
+        iq_cond->set_sample_rate(d_input_rate);
+
         tb->lock();
-        d_input_rate = src->set_sample_rate(rate);
-        dc_corr->set_sample_rate(d_input_rate);
-        rx->set_quad_rate(d_input_rate);
-        lo->set_sampling_freq(d_input_rate);
+        /* channelizer outputs depend on the rate, rebuild them */
+        if (d_pfb_nchans > 0)
+        {
+            for (unsigned int i = 0; i < d_channels.size(); i++)
+                if (d_channels[i].pfb_index >= 0)
+                    disconnect_channel(d_channels[i]);
+            disconnect_channelizer();
+        }
+        update_quad_rate();
+        if (d_pfb_nchans > 0)
+        {
+            rebuild_channelizer();
+            if (d_pfb_nchans > 0)
+                connect_channelizer();
+            for (unsigned int i = 0; i < d_channels.size(); i++)
+                if (d_channels[i].pfb_index >= 0)
+                    connect_channel(d_channels[i]);
+        }
         tb->unlock();
+
+        d_reconf_time += reconf_time_ms(t0);
     }
 
     return d_input_rate;
@@ -266,6 +604,75 @@ double receiver::get_input_rate()
     return d_input_rate;
 }
 
+/*! \brief Set input decimation.
+ *  \param decim The decimation, 1 (off) or a power of 2 up to 256.
+ *  \return The actual decimation.
+ *
+ * The decimator is inserted after the I/Q conditioning blocks so that
+ * the baseband FFT, the receivers and the channels all run at
+ * input_rate / decim. An active channelizer is rebuilt like in
+ * set_input_rate().
+ */
+unsigned int receiver::set_input_decim(unsigned int decim)
+{
+    if (decim == d_decim)
+        return d_decim;
+
+    if ((decim < 1) || (decim > 256) || (decim & (decim - 1)))
+    {
+        std::cout << "Invalid input decimation: " << decim << std::endl;
+        return d_decim;
+    }
+
+    boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+
+    tb->lock();
+    tb->disconnect_all();
+
+    input_decim.reset();
+    d_decim = decim;
+    if (d_decim > 1)
+        input_decim = make_fir_decim_cc(d_decim);
+
+    d_quad_rate = d_input_rate / d_decim;
+    update_quad_rate();
+    if (d_pfb_nchans > 0)
+        rebuild_channelizer();
+
+    if (d_demod == RX_DEMOD_OFF)
+        connect_all(RX_CHAIN_NONE);
+    else if ((d_demod == RX_DEMOD_WFM_M) || (d_demod == RX_DEMOD_WFM_S))
+        connect_all(RX_CHAIN_WFMRX);
+    else
+        connect_all(RX_CHAIN_NBRX);
+    tb->unlock();
+
+    d_reconf_time += reconf_time_ms(t0);
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    std::cout << "Input decimation " << d_decim << ": processing "
+              << d_quad_rate << " sps instead of " << d_input_rate << " sps" << std::endl;
+#endif
+
+    return d_decim;
+}
+
+/*! \brief Propagate the rate after input decimation. The caller must lock the graph. */
+void receiver::update_quad_rate()
+{
+    rx->set_quad_rate(d_quad_rate);
+    rotator->set_sample_rate(d_quad_rate);
+    for (unsigned int i = 0; i < d_channels.size(); i++)
+    {
+        /* channelizer channels are updated by rebuild_channelizer() */
+        if (d_channels[i].pfb_index >= 0)
+            continue;
+        d_channels[i].rx->set_quad_rate(d_quad_rate);
+        d_channels[i].rotator->set_sample_rate(d_quad_rate);
+    }
+    update_iq_fft_period();
+}
+
 /*! \brief Set new analog bandwidth.
  *  \param bw The new bandwidth.
  *  \return The actual bandwidth.
@@ -290,7 +697,7 @@ void receiver::set_iq_swap(bool reversed)
         return;
 
     d_iq_rev = reversed;
-    iq_swap->set_enabled(d_iq_rev);
+    iq_cond->set_swap(d_iq_rev);
 }
 
 /*! \brief Get current I/Q reversed setting.
@@ -311,12 +718,7 @@ void receiver::set_dc_cancel(bool enable)
         return;
 
     d_dc_cancel = enable;
-
-    // until we have a way to switch on/off
-    // inside the dc_corr_cc we do a reconf
-    rx_demod demod = d_demod;
-    d_demod = RX_DEMOD_OFF;
-    set_demod(demod);
+    iq_cond->set_dc_cancel(d_dc_cancel);
 }
 
 /*! \brief Get auto DC cancel status.
@@ -338,7 +740,7 @@ void receiver::set_iq_balance(bool enable)
 
     d_iq_balance = enable;
 
-    src->set_iq_balance_mode(enable ? 2 : 0);
+    iq_cond->set_iq_balance(d_iq_balance);
 }
 
 /*! \brief Get auto I/Q balance status.
@@ -482,7 +884,7 @@ receiver::status receiver::set_rf_gain(double gain_rel)
 receiver::status receiver::set_filter_offset(double offset_hz)
 {
     d_filter_offset = offset_hz;
-    lo->set_frequency(-d_filter_offset);
+    rotator->set_freq(-d_filter_offset);
 
     return STATUS_OK;
 }
@@ -570,14 +972,52 @@ void receiver::set_iq_fft_size(int newsize)
     iq_fft->set_fft_size(newsize);
 }
 
-/*! \brief Get latest baseband FFT data. */
-void receiver::get_iq_fft_data(std::complex<float>* fftPoints, unsigned int &fftsize)
+/*! \brief Set baseband FFT display rate.
+ *  \param fps The rate in frames per second (0 means paused).
+ *
+ * This is used to set the averaging period in Welch mode.
+ */
+void receiver::set_iq_fft_rate(int fps)
+{
+    d_iq_fft_rate = fps;
+    update_iq_fft_period();
+}
+
+/*! \brief Enable or disable Welch averaging for the baseband FFT.
+ *  \param enable Whether to use overlapped, averaged FFTs.
+ *  \param overlap Segment overlap between 0.0 and 0.9.
+ */
+void receiver::set_iq_fft_welch(bool enable, float overlap)
 {
-    iq_fft->get_fft_data(fftPoints, fftsize);
+    iq_fft->set_welch(enable, overlap);
 }
 
-/*! \brief Get latest audio FFT data. */
-void receiver::get_audio_fft_data(std::complex<float>* fftPoints, unsigned int &fftsize)
+/*! \brief Update Welch period of the baseband FFT to match sample and display rate. */
+void receiver::update_iq_fft_period()
+{
+    int fps = d_iq_fft_rate > 0 ? d_iq_fft_rate : 1;
+
+    iq_fft->set_welch_period((unsigned int)(d_quad_rate / fps));
+}
+
+/*! \brief Set baseband FFT averaging parameter (0.0 to 1.0). */
+void receiver::set_iq_fft_avg(float avg)
+{
+    iq_fft->set_averaging(avg);
+}
+
+/*! \brief Get latest baseband FFT data.
+ *  \param fftPoints Averaged power spectrum in dBFS (pandapter).
+ *  \param wfPoints Power spectrum of the latest FFT frame in dBFS (waterfall).
+ *  \param fftsize The FFT size (output), 0 if there is no new data.
+ */
+void receiver::get_iq_fft_data(float *fftPoints, float *wfPoints, unsigned int &fftsize)
+{
+    iq_fft->get_fft_data(fftPoints, wfPoints, fftsize);
+}
+
+/*! \brief Get latest audio FFT data (power spectrum in dBFS). */
+void receiver::get_audio_fft_data(float *fftPoints, unsigned int &fftsize)
 {
     audio_fft->get_fft_data(fftPoints, fftsize);
 }
@@ -677,20 +1117,40 @@ receiver::status receiver::set_agc_manual_gain(int gain)
     return STATUS_OK; // FIXME
 }
 
+/*! \brief Select demodulator.
+ *
+ * Switching between the SSB, AM and FM demodulators, or between WFM mono
+ * and stereo, is done inside the receiver without touching the flow graph.
+ *
+ * Switching chain type (or turning the demodulator on or off) rewires the
+ * graph under tb->lock(), and so does switching to or from QPSK and DSD
+ * inside nbrx. This is not glitch free: unlock() stops and restarts every
+ * block, including the source and the audio sink, so the audio drops out
+ * for as long as the graph is locked. The time of these locked switches
+ * is added to get_reconf_time(); the lock-free switches are not counted.
+ */
 receiver::status receiver::set_demod(rx_demod demod)
 {
-    bool needs_restart = d_running;
+    boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
     bool wide_fm = (d_demod == RX_DEMOD_WFM_M) || (d_demod == RX_DEMOD_WFM_S);
+    bool new_wide_fm = (demod == RX_DEMOD_WFM_M) || (demod == RX_DEMOD_WFM_S);
+    bool reconf = (demod == RX_DEMOD_OFF) || (d_demod == RX_DEMOD_OFF) ||
+                  (wide_fm != new_wide_fm);
+    /* nbrx locks itself when switching to or from QPSK and DSD */
+    bool nbrx_rewire = !reconf && !new_wide_fm && (demod != d_demod) &&
+                       ((demod == RX_DEMOD_QPSK) || (demod == RX_DEMOD_DSD) ||
+                        (d_demod == RX_DEMOD_QPSK) || (d_demod == RX_DEMOD_DSD));
     status ret = STATUS_OK;
 
     // Allow reconf using same demod to provide a workaround
     // for the "jerky streaming" we may experience with rtl
-    // dongles (the jerkyness disappears when we run this function)
-    //if (demod == d_demod)
-    //    return ret;
+    // dongles (the jerkyness disappears when we restart the graph)
+    bool needs_restart = d_running && (demod == d_demod);
 
-    if (d_running)
+    if (needs_restart)
         stop();
+    else if (reconf)
+        tb->lock();
 
     switch (demod)
     {
@@ -780,6 +1240,12 @@ receiver::status receiver::set_demod(rx_demod demod)
 
     if (needs_restart)
         start();
+    else if (reconf)
+        tb->unlock();
+
+    /* analog mode switches do not lock and are not counted */
+    if (d_running && !needs_restart && (reconf || nbrx_rewire))
+        d_reconf_time += reconf_time_ms(t0);
 
     return ret;
 }
@@ -1094,7 +1560,10 @@ receiver::status receiver::start_sniffer(unsigned int samprate, int buffsize)
         return STATUS_ERROR;
     }
 
+    /* drop samples left from the previous session, the queue is not
+     * reallocated when the size is unchanged */
     sniffer->set_buffer_size(buffsize);
+    sniffer->clear();
     sniffer_rr = make_resampler_ff((float)samprate/(float)d_audio_rate);
     tb->lock();
     tb->connect(rx, 0, sniffer_rr, 0);
@@ -1133,45 +1602,541 @@ void receiver::get_sniffer_data(float * outbuff, unsigned int &num)
 }
 
 
+/*! \brief Add a new channel.
+ *  \param offset_hz The frequency offset of the channel in Hz.
+ *  \param demod The demodulator to use (RX_DEMOD_OFF is not allowed).
+ *  \param wav_filename WAV file to record the channel audio to. If empty,
+ *                      the audio is discarded (e.g. to only use the meter).
+ *  \return The ID of the new channel or -1 if an error occurred.
+ *
+ * Channels are independent receivers attached to the same I/Q source as
+ * the main receiver. They can be added and removed while the receiver is
+ * running.
+ */
+int receiver::add_channel(double offset_hz, rx_demod demod, const std::string wav_filename)
+{
+    rx_channel ch;
 
-/*! \brief Convenience function to connect all blocks. */
-void receiver::connect_all(rx_chain type)
+    ch.offset = offset_hz;
+    ch.pfb_index = -1;
+    ch.rotator = make_rx_rotator_cc(d_quad_rate, -offset_hz);
+
+    return create_channel(ch, d_quad_rate, demod, wav_filename);
+}
+
+/*! \brief Create the demodulator and sinks of a new channel and connect it.
+ *  \param ch The channel with offset, pfb_index and rotator already set.
+ *  \param rate The sample rate at the input of the demodulator.
+ *  \param demod The demodulator.
+ *  \param wav_filename WAV file name or empty string.
+ *  \return The ID of the new channel or -1 if an error occurred.
+ */
+int receiver::create_channel(rx_channel &ch, double rate, rx_demod demod,
+                             const std::string &wav_filename)
 {
-    switch (type)
+    bool wide_fm = (demod == RX_DEMOD_WFM_M) || (demod == RX_DEMOD_WFM_S);
+
+    if ((demod <= RX_DEMOD_OFF) || (demod > RX_DEMOD_DSD))
+        return -1;
+
+    ch.id = d_next_channel_id;
+    if (wide_fm)
+        ch.rx = make_wfmrx(rate, d_audio_rate);
+    else
+        ch.rx = make_nbrx(rate, d_audio_rate);
+
+    if (wav_filename.empty())
     {
-    case RX_CHAIN_NONE:
-        tb->connect(src, 0, iq_swap, 0);
-        if (d_dc_cancel)
-        {
-            tb->connect(iq_swap, 0, dc_corr, 0);
-            tb->connect(dc_corr, 0, iq_fft, 0);
+        ch.sink0 = gr::blocks::null_sink::make(sizeof(float));
+        ch.sink1 = gr::blocks::null_sink::make(sizeof(float));
+    }
+    else
+    {
+        try {
+            ch.wav_sink = gr::blocks::wavfile_sink::make(wav_filename.c_str(), 2,
+                                                         (unsigned int) d_audio_rate,
+                                                         16);
         }
-        else
+        catch (std::runtime_error &e) {
+            std::cout << "Error opening " << wav_filename << ": " << e.what() << std::endl;
+            return -1;
+        }
+        ch.sink0 = ch.wav_sink;
+    }
+
+    tb->lock();
+    connect_channel(ch);
+
+    switch (demod)
+    {
+    case RX_DEMOD_NONE:
+        ch.rx->set_demod(nbrx::NBRX_DEMOD_NONE);
+        break;
+    case RX_DEMOD_AM:
+        ch.rx->set_demod(nbrx::NBRX_DEMOD_AM);
+        break;
+    case RX_DEMOD_WFM_M:
+        ch.rx->set_demod(wfmrx::WFMRX_DEMOD_MONO);
+        break;
+    case RX_DEMOD_WFM_S:
+        ch.rx->set_demod(wfmrx::WFMRX_DEMOD_STEREO);
+        break;
+    case RX_DEMOD_SSB:
+        ch.rx->set_demod(nbrx::NBRX_DEMOD_SSB);
+        break;
+    case RX_DEMOD_QPSK:
+        ch.rx->set_demod(nbrx::NBRX_DEMOD_QPSK);
+        break;
+    case RX_DEMOD_DSD:
+        ch.rx->set_demod(nbrx::NBRX_DEMOD_DSD);
+        break;
+    case RX_DEMOD_NFM:
+    default:
+        /* nbrx is created with the FM demodulator */
+        break;
+    }
+    tb->unlock();
+
+    d_channels.push_back(ch);
+    d_next_channel_id++;
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    std::cout << "Added channel " << ch.id << " at offset " << ch.offset
+              << " Hz (" << d_channels.size() << " channels)" << std::endl;
+#endif
+
+    return ch.id;
+}
+
+/*! \brief Remove a channel.
+ *  \param id The channel ID returned by add_channel().
+ */
+receiver::status receiver::remove_channel(int id)
+{
+    std::vector<rx_channel>::iterator it;
+
+    for (it = d_channels.begin(); it != d_channels.end(); ++it)
+    {
+        if (it->id == id)
         {
-            tb->connect(iq_swap, 0, iq_fft, 0);
+            tb->lock();
+            disconnect_channel(*it);
+            tb->unlock();
+
+            if (it->wav_sink)
+                it->wav_sink->close();
+
+            d_channels.erase(it);
+
+            return STATUS_OK;
         }
+    }
+
+    return STATUS_ERROR;
+}
+
+/*! \brief Set the frequency offset of a channel. */
+receiver::status receiver::set_channel_offset(int id, double offset_hz)
+{
+    rx_channel *ch = find_channel(id);
+
+    if (!ch)
+        return STATUS_ERROR;
+
+    /* channelizer outputs have fixed frequencies */
+    if (ch->pfb_index >= 0)
+        return STATUS_ERROR;
+
+    ch->offset = offset_hz;
+    ch->rotator->set_freq(-offset_hz);
+
+    return STATUS_OK;
+}
+
+/*! \brief Set the filter of a channel.
+ *  \sa set_filter()
+ */
+receiver::status receiver::set_channel_filter(int id, double low, double high, filter_shape shape)
+{
+    rx_channel *ch = find_channel(id);
+    double trans_width;
+
+    if (!ch || (low >= high) || (abs(high-low) < RX_FILTER_MIN_WIDTH))
+        return STATUS_ERROR;
+
+    switch (shape) {
+
+    case FILTER_SHAPE_SOFT:
+        trans_width = abs(high-low)*0.2;
         break;
 
-    case RX_CHAIN_NBRX:
-        if (rx->name() != "NBRX")
+    case FILTER_SHAPE_SHARP:
+        trans_width = abs(high-low)*0.01;
+        break;
+
+    case FILTER_SHAPE_NORMAL:
+    default:
+        trans_width = abs(high-low)*0.1;
+        break;
+
+    }
+
+    ch->rx->set_filter(low, high, trans_width);
+
+    return STATUS_OK;
+}
+
+/*! \brief Set the squelch level of a channel in dBFS. */
+receiver::status receiver::set_channel_sql_level(int id, double level_db)
+{
+    rx_channel *ch = find_channel(id);
+
+    if (!ch)
+        return STATUS_ERROR;
+
+    if (ch->rx->has_sql())
+        ch->rx->set_sql_level(level_db);
+
+    return STATUS_OK;
+}
+
+/*! \brief Get the signal power of a channel.
+ *  \sa get_signal_pwr()
+ */
+float receiver::get_channel_signal_pwr(int id, bool dbfs)
+{
+    rx_channel *ch = find_channel(id);
+
+    if (!ch)
+        return dbfs ? -150.0 : 0.0;
+
+    return ch->rx->get_signal_level(dbfs);
+}
+
+/*! \brief Find a channel by ID.
+ *  \return Pointer to the channel or NULL if there is no such channel.
+ */
+receiver::rx_channel *receiver::find_channel(int id)
+{
+    for (unsigned int i = 0; i < d_channels.size(); i++)
+        if (d_channels[i].id == id)
+            return &d_channels[i];
+
+    return 0;
+}
+
+/*! \brief Connect the source, I/Q conditioning and input decimator. The caller must lock the graph. */
+void receiver::connect_iq_chain()
+{
+    tb->connect(src, 0, iq_cond, 0);
+    if (d_decim > 1)
+        tb->connect(iq_cond, 0, input_decim, 0);
+}
+
+/*! \brief Get the last block of the I/Q chain (at the decimated rate). */
+gr::basic_block_sptr receiver::iq_output()
+{
+    if (d_decim > 1)
+        return input_decim;
+    else
+        return iq_cond;
+}
+
+/*! \brief Connect a channel to the I/Q chain. The caller must lock the graph. */
+void receiver::connect_channel(rx_channel &ch)
+{
+    if (ch.pfb_index >= 0)
+    {
+        tb->connect(pfb, ch.pfb_index, ch.rx, 0);
+    }
+    else
+    {
+        tb->connect(iq_output(), 0, ch.rotator, 0);
+        tb->connect(ch.rotator, 0, ch.rx, 0);
+    }
+    tb->connect(ch.rx, 0, ch.sink0, 0);
+    if (ch.wav_sink)
+        tb->connect(ch.rx, 1, ch.sink0, 1);
+    else
+        tb->connect(ch.rx, 1, ch.sink1, 0);
+}
+
+/*! \brief Disconnect a channel from the I/Q chain. The caller must lock the graph. */
+void receiver::disconnect_channel(rx_channel &ch)
+{
+    if (ch.pfb_index >= 0)
+    {
+        tb->disconnect(pfb, ch.pfb_index, ch.rx, 0);
+    }
+    else
+    {
+        tb->disconnect(iq_output(), 0, ch.rotator, 0);
+        tb->disconnect(ch.rotator, 0, ch.rx, 0);
+    }
+    tb->disconnect(ch.rx, 0, ch.sink0, 0);
+    if (ch.wav_sink)
+        tb->disconnect(ch.rx, 1, ch.sink0, 1);
+    else
+        tb->disconnect(ch.rx, 1, ch.sink1, 0);
+}
+
+
+/*! \brief Start the polyphase filterbank channelizer.
+ *  \param spacing_hz The desired channel spacing, e.g. 12500.
+ *
+ * The channelizer splits the whole input band into equally spaced
+ * channels in a single pass over the input (one polyphase filter and one
+ * FFT per output sample). The number of channels is input rate / spacing
+ * rounded to the nearest integer, so the actual spacing may differ
+ * slightly; see get_channelizer_spacing(). Each output runs at twice the
+ * channel spacing so that channels at the band edges are not attenuated.
+ *
+ * Demodulators are attached to individual outputs using
+ * add_channelizer_channel(). When the input rate or decimation changes
+ * the channelizer is rebuilt for the same spacing; see
+ * rebuild_channelizer().
+ */
+receiver::status receiver::start_channelizer(double spacing_hz)
+{
+    if (spacing_hz <= 0.0)
+        return STATUS_ERROR;
+
+    if ((unsigned int) (d_quad_rate / spacing_hz + 0.5) < 2)
+        return STATUS_ERROR;
+
+    if (d_pfb_nchans > 0)
+        stop_channelizer();
+
+    tb->lock();
+    d_pfb_spacing = spacing_hz;
+    create_channelizer();
+    connect_channelizer();
+    tb->unlock();
+
+    return STATUS_OK;
+}
+
+/*! \brief Create the channelizer blocks for d_pfb_spacing at the current rate.
+ *  \return true if the channelizer was created, false if the rate is too
+ *          low for two channels.
+ */
+bool receiver::create_channelizer()
+{
+    unsigned int nchans = (unsigned int) (d_quad_rate / d_pfb_spacing + 0.5);
+    double spacing_hz;
+    std::vector<float> taps;
+
+    pfb.reset();
+    pfb_s2ss.reset();
+    pfb_null.clear();
+    d_pfb_nchans = 0;
+
+    if (nchans < 2)
+        return false;
+
+    spacing_hz = d_quad_rate / nchans;
+    taps = gr::filter::firdes::low_pass_2(1.0, d_quad_rate,
+                                          0.5 * spacing_hz, 0.2 * spacing_hz,
+                                          60.0);
+
+    d_pfb_nchans = nchans;
+    pfb_s2ss = gr::blocks::stream_to_streams::make(sizeof(gr_complex), nchans);
+    pfb = gr::filter::pfb_channelizer_ccf::make(nchans, taps, 2.0);
+    pfb_null.resize(nchans);
+    for (unsigned int i = 0; i < nchans; i++)
+        pfb_null[i] = gr::blocks::null_sink::make(sizeof(gr_complex));
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    std::cout << "Channelizer: " << nchans << " channels, "
+              << spacing_hz << " Hz spacing, " << taps.size() << " taps" << std::endl;
+#endif
+
+    return true;
+}
+
+/*! \brief Rebuild the channelizer after a rate change.
+ *  \return The number of channels that were removed.
+ *
+ * The channelizer is created again for the same spacing at the new rate
+ * and every channel is moved to the output closest to its old offset.
+ * Channels outside the new band, or all of them if the rate has become
+ * too low, are removed and their WAV files closed; use has_channel() to
+ * find out which. The caller must lock the graph and must have
+ * disconnected the channelizer and its channels.
+ */
+unsigned int receiver::rebuild_channelizer()
+{
+    std::vector<rx_channel>::iterator it;
+    unsigned int lost = 0;
+    bool ok = create_channelizer();
+    int index;
+
+    for (it = d_channels.begin(); it != d_channels.end(); )
+    {
+        if (it->pfb_index < 0)
         {
-            rx.reset();
-            rx = make_nbrx(d_input_rate, d_audio_rate);
+            ++it;
+            continue;
         }
-        tb->connect(src, 0, iq_swap, 0);
-        if (d_dc_cancel)
+
+        if (!ok || fabs(it->offset) > 0.5 * d_quad_rate)
         {
-            tb->connect(iq_swap, 0, dc_corr, 0);
-            tb->connect(dc_corr, 0, iq_fft, 0);
-            tb->connect(dc_corr, 0, mixer, 0);
+            if (it->wav_sink)
+                it->wav_sink->close();
+            it = d_channels.erase(it);
+            lost++;
+            continue;
+        }
+
+        index = get_channelizer_index(it->offset);
+        it->pfb_index = index;
+        it->offset = (index <= (int) d_pfb_nchans / 2 ? index : index - (int) d_pfb_nchans) *
+                     get_channelizer_spacing();
+        it->rx->set_quad_rate(2.0 * get_channelizer_spacing());
+        ++it;
+    }
+
+    if (!ok)
+        d_pfb_spacing = 0.0;
+
+    if (lost > 0)
+        std::cout << "Channelizer: " << lost << " channels removed after rate change" << std::endl;
+
+    return lost;
+}
+
+/*! \brief Stop the channelizer and remove all channels attached to it. */
+receiver::status receiver::stop_channelizer()
+{
+    std::vector<rx_channel>::iterator it;
+
+    if (d_pfb_nchans == 0)
+        return STATUS_ERROR;
+
+    tb->lock();
+    for (it = d_channels.begin(); it != d_channels.end(); )
+    {
+        if (it->pfb_index >= 0)
+        {
+            disconnect_channel(*it);
+            if (it->wav_sink)
+                it->wav_sink->close();
+            it = d_channels.erase(it);
         }
         else
         {
-            tb->connect(iq_swap, 0, iq_fft, 0);
-            tb->connect(iq_swap, 0, mixer, 0);
+            ++it;
+        }
+    }
+    disconnect_channelizer();
+    d_pfb_nchans = 0;
+    d_pfb_spacing = 0.0;
+    tb->unlock();
+
+    pfb.reset();
+    pfb_s2ss.reset();
+    pfb_null.clear();
+
+    return STATUS_OK;
+}
+
+/*! \brief Get the actual channel spacing of the channelizer in Hz. */
+double receiver::get_channelizer_spacing()
+{
+    if (d_pfb_nchans == 0)
+        return 0.0;
+
+    return d_quad_rate / d_pfb_nchans;
+}
+
+/*! \brief Get the channelizer output closest to a frequency offset.
+ *  \param offset_hz The offset from the center frequency in Hz.
+ *  \return The output index or -1 if the channelizer is not active.
+ *
+ * Output 0 is at the center frequency, outputs 1 to N/2 are above and the
+ * remaining outputs below the center frequency.
+ */
+int receiver::get_channelizer_index(double offset_hz)
+{
+    int n = (int) d_pfb_nchans;
+    int index;
+
+    if (n == 0)
+        return -1;
+
+    index = (int) floor(offset_hz / get_channelizer_spacing() + 0.5);
+    index %= n;
+    if (index < 0)
+        index += n;
+
+    return index;
+}
+
+/*! \brief Attach a demodulator to a channelizer output.
+ *  \param index The channelizer output, see get_channelizer_index().
+ *  \param demod The demodulator.
+ *  \param wav_filename WAV file to record to or empty string.
+ *  \return The channel ID or -1 if an error occurred.
+ *  \sa add_channel(), remove_channel()
+ */
+int receiver::add_channelizer_channel(int index, rx_demod demod, const std::string wav_filename)
+{
+    rx_channel ch;
+    int n = (int) d_pfb_nchans;
+
+    if ((index < 0) || (index >= n))
+        return -1;
+
+    ch.pfb_index = index;
+    ch.offset = (index <= n / 2 ? index : index - n) * get_channelizer_spacing();
+
+    return create_channel(ch, 2.0 * get_channelizer_spacing(), demod, wav_filename);
+}
+
+/*! \brief Connect the channelizer to the I/Q chain. The caller must lock the graph. */
+void receiver::connect_channelizer()
+{
+    tb->connect(iq_output(), 0, pfb_s2ss, 0);
+    for (unsigned int i = 0; i < d_pfb_nchans; i++)
+    {
+        tb->connect(pfb_s2ss, i, pfb, i);
+        tb->connect(pfb, i, pfb_null[i], 0);
+    }
+}
+
+/*! \brief Disconnect the channelizer from the I/Q chain. The caller must lock the graph. */
+void receiver::disconnect_channelizer()
+{
+    tb->disconnect(iq_output(), 0, pfb_s2ss, 0);
+    for (unsigned int i = 0; i < d_pfb_nchans; i++)
+    {
+        tb->disconnect(pfb_s2ss, i, pfb, i);
+        tb->disconnect(pfb, i, pfb_null[i], 0);
+    }
+}
+
+
+
+/*! \brief Convenience function to connect all blocks. */
+void receiver::connect_all(rx_chain type)
+{
+    switch (type)
+    {
+    case RX_CHAIN_NONE:
+        connect_iq_chain();
+        tb->connect(iq_output(), 0, iq_fft, 0);
+        break;
+
+    case RX_CHAIN_NBRX:
+        if (rx->name() != "NBRX")
+        {
+            rx.reset();
+            rx = make_nbrx(d_quad_rate, d_audio_rate);
         }
-        tb->connect(lo, 0, mixer, 1);
-        tb->connect(mixer, 0, rx, 0);
+        connect_iq_chain();
+        tb->connect(iq_output(), 0, iq_fft, 0);
+        tb->connect(iq_output(), 0, rotator, 0);
+        tb->connect(rotator, 0, rx, 0);
         tb->connect(rx, 0, audio_fft, 0);
         tb->connect(rx, 0, audio_gain0, 0);
         tb->connect(rx, 1, audio_gain1, 0);
@@ -1183,22 +2148,12 @@ void receiver::connect_all(rx_chain type)
         if (rx->name() != "WFMRX")
         {
             rx.reset();
-            rx = make_wfmrx(d_input_rate, d_audio_rate);
+            rx = make_wfmrx(d_quad_rate, d_audio_rate);
         }
-        tb->connect(src, 0, iq_swap, 0);
-        if (d_dc_cancel)
-        {
-            tb->connect(iq_swap, 0, dc_corr, 0);
-            tb->connect(dc_corr, 0, iq_fft, 0);
-            tb->connect(dc_corr, 0, mixer, 0);
-        }
-        else
-        {
-            tb->connect(iq_swap, 0, iq_fft, 0);
-            tb->connect(iq_swap, 0, mixer, 0);
-        }
-        tb->connect(lo, 0, mixer, 1);
-        tb->connect(mixer, 0, rx, 0);
+        connect_iq_chain();
+        tb->connect(iq_output(), 0, iq_fft, 0);
+        tb->connect(iq_output(), 0, rotator, 0);
+        tb->connect(rotator, 0, rx, 0);
         tb->connect(rx, 0, audio_fft, 0);
         tb->connect(rx, 0, audio_gain0, 0);
         tb->connect(rx, 1, audio_gain1, 0);
@@ -1216,4 +2171,150 @@ void receiver::connect_all(rx_chain type)
         tb->connect(rx, 0, sniffer_rr, 0);
         tb->connect(sniffer_rr, 0, sniffer, 0);
     }
+
+    // re-connect channelizer and additional channels
+    if (d_pfb_nchans > 0)
+        connect_channelizer();
+    for (unsigned int i = 0; i < d_channels.size(); i++)
+        connect_channel(d_channels[i]);
+}
+
+/*! \brief Collect the gqrx owned blocks of the flow graph. */
+void receiver::get_blocks(std::vector<gr::basic_block_sptr> &blocks)
+{
+    blocks.push_back(iq_cond);
+    if (d_decim > 1)
+        blocks.push_back(input_decim);
+    blocks.push_back(iq_fft);
+    blocks.push_back(rotator);
+    rx->get_blocks(blocks);
+    blocks.push_back(audio_fft);
+    blocks.push_back(audio_gain0);
+    blocks.push_back(audio_gain1);
+    blocks.push_back(audio_snk);
+
+    if (d_sniffer_active)
+    {
+        blocks.push_back(sniffer_rr);
+        blocks.push_back(sniffer);
+    }
+
+    if (d_pfb_nchans > 0)
+    {
+        blocks.push_back(pfb_s2ss);
+        blocks.push_back(pfb);
+    }
+
+    for (unsigned int i = 0; i < d_channels.size(); i++)
+    {
+        if (d_channels[i].rotator)
+            blocks.push_back(d_channels[i].rotator);
+        d_channels[i].rx->get_blocks(blocks);
+    }
+}
+
+/*!
+ * \brief Get performance data of the blocks in the flow graph.
+ * \param perf Vector that will be filled with one entry per block.
+ *
+ * The work time and buffer fullness are the running averages kept by the
+ * GNU Radio performance counters. Busy fraction and throughput are computed
+ * from the difference to the previous call, so the first call after a block
+ * was (re)created reports them as 0.
+ *
+ * Only blocks that are part of the running flow graph are reported. Blocks
+ * inside hierarchical blocks (e.g. the FM demodulator) are not listed.
+ */
+void receiver::get_block_perf(std::vector<block_perf> &perf)
+{
+    std::vector<gr::basic_block_sptr> blocks;
+    std::map<long, perf_state>        state;
+    gr::high_res_timer_type           now = gr::high_res_timer_now();
+    double                            tps = (double) gr::high_res_timer_tps();
+
+    perf.clear();
+    get_blocks(blocks);
+
+    for (unsigned int i = 0; i < blocks.size(); i++)
+    {
+        gr::block_sptr blk = boost::dynamic_pointer_cast<gr::block>(blocks[i]);
+
+        if (!blk || !blk->detail() || state.count(blk->unique_id()))
+            continue;
+
+        perf_state &cur = state[blk->unique_id()];
+        cur.work_total = blk->pc_work_time_total();
+        cur.nitems = (blk->detail()->noutputs() > 0) ?
+                    blk->nitems_written(0) : blk->nitems_read(0);
+        cur.time = now;
+
+        block_perf p;
+        p.name = blk->alias();
+        p.work_time = 1.0e6 * blk->pc_work_time_avg() / tps;
+        p.busy = 0.0;
+        p.throughput = 0.0;
+        p.in_full = max_fullness(blk->pc_input_buffers_full_avg());
+        p.out_full = max_fullness(blk->pc_output_buffers_full_avg());
+
+        std::map<long, perf_state>::const_iterator prev =
+                d_perf_state.find(blk->unique_id());
+        if (prev != d_perf_state.end() && now > prev->second.time &&
+            cur.nitems >= prev->second.nitems)
+        {
+            double dt = (double)(now - prev->second.time) / tps;
+
+            p.busy = (cur.work_total - prev->second.work_total) / tps / dt;
+            p.throughput = (double)(cur.nitems - prev->second.nitems) / dt;
+        }
+
+        perf.push_back(p);
+    }
+
+    // forget blocks that are no longer in the flow graph
+    d_perf_state.swap(state);
+}
+
+/*! \brief CPU load of the flow graph since the previous call.
+ *  \return Time spent in work() by all blocks after the source, divided by
+ *          the elapsed time, i.e. 1.0 is one fully used core. 0 on the
+ *          first call or if the performance counters are off.
+ *
+ * Keeps its own snapshot so that it does not disturb get_block_perf().
+ * Blocks that are new since the previous call, or whose counters were
+ * reset when the flow graph was reconfigured, count with their whole total.
+ */
+double receiver::get_dsp_load()
+{
+    std::vector<gr::basic_block_sptr> blocks;
+    std::map<long, float>             totals;
+    gr::high_res_timer_type           now = gr::high_res_timer_now();
+    double                            work = 0.0;
+    double                            load = 0.0;
+
+    get_blocks(blocks);
+
+    for (unsigned int i = 0; i < blocks.size(); i++)
+    {
+        gr::block_sptr blk = boost::dynamic_pointer_cast<gr::block>(blocks[i]);
+
+        if (!blk || !blk->detail() || totals.count(blk->unique_id()))
+            continue;
+
+        float total = blk->pc_work_time_total();
+        totals[blk->unique_id()] = total;
+
+        std::map<long, float>::const_iterator prev = d_load_totals.find(blk->unique_id());
+        if ((prev != d_load_totals.end()) && (total >= prev->second))
+            work += total - prev->second;
+        else
+            work += total;
+    }
+
+    if ((d_load_time > 0) && (now > d_load_time))
+        load = work / (double)(now - d_load_time);
+
+    d_load_totals.swap(totals);
+    d_load_time = now;
+
+    return load;
 }
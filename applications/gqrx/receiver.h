@@ -23,22 +23,30 @@
 #ifndef RECEIVER_H
 #define RECEIVER_H
 
+#include <map>
 #include <string>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <gnuradio/blocks/multiply_const_ff.h>
-#include <gnuradio/blocks/multiply_cc.h>
 #include <gnuradio/blocks/null_sink.h>
-#include <gnuradio/analog/sig_source_c.h>
+#include <gnuradio/blocks/stream_to_streams.h>
+#include <gnuradio/filter/pfb_channelizer_ccf.h>
+#include <gnuradio/high_res_timer.h>
 #include <gnuradio/top_block.h>
 #include <gnuradio/blocks/wavfile_sink.h>
 #include <gnuradio/blocks/wavfile_source.h>
 
 #include <osmosdr/source.h>
 
-#include "dsp/correct_iq_cc.h"
+#include "dsp/iq_condition_cc.h"
+#include "dsp/filter/fir_decim.h"
 #include "dsp/rx_noise_blanker_cc.h"
 #include "dsp/rx_filter.h"
 #include "dsp/rx_meter.h"
+#include "dsp/rx_rotator.h"
 #include "dsp/rx_agc_xx.h"
 #include "dsp/rx_demod_fm.h"
 #include "dsp/rx_demod_am.h"
@@ -107,10 +115,17 @@ public:
     receiver(const std::string input_device="", const std::string audio_device="");
     ~receiver();
 
+    static bool load_fft_wisdom(const std::string filename);
+    static bool save_fft_wisdom(const std::string filename);
+
     void start();
     void stop();
 
-    void set_input_device(const std::string device);
+    void   prepare_input_device(const std::string device);
+    void   prepare_input_rate(double rate);
+    bool   is_input_prepared();
+
+    status set_input_device(const std::string device);
     void set_output_device(const std::string device);
 
     std::vector<std::string> get_antennas(void);
@@ -119,6 +134,21 @@ public:
     double set_input_rate(double rate);
     double get_input_rate();
 
+    unsigned int set_input_decim(unsigned int decim);
+    unsigned int get_input_decim() { return d_decim; }
+
+    /*! \brief Sample rate after input decimation. */
+    double get_quad_rate() { return d_quad_rate; }
+
+    /*! \brief Time the flow graph was locked since reset_reconf_time() in ms.
+     *
+     * Input device, output device, input rate, input decimation and
+     * demodulator changes add their lock time, so a reconfiguration made
+     * of several calls is reported as a whole.
+     */
+    double get_reconf_time() { return d_reconf_time; }
+    void   reset_reconf_time() { d_reconf_time = 0.0; }
+
     double set_analog_bandwidth(double bw);
     double get_analog_bandwidth();
 
@@ -152,8 +182,11 @@ public:
     float get_signal_pwr(bool dbfs);
 
     void set_iq_fft_size(int newsize);
-    void get_iq_fft_data(std::complex<float>* fftPoints, unsigned int &fftsize);
-    void get_audio_fft_data(std::complex<float>* fftPoints, unsigned int &fftsize);
+    void set_iq_fft_rate(int fps);
+    void set_iq_fft_avg(float avg);
+    void set_iq_fft_welch(bool enable, float overlap);
+    void get_iq_fft_data(float *fftPoints, float *wfPoints, unsigned int &fftsize);
+    void get_audio_fft_data(float *fftPoints, unsigned int &fftsize);
 
     /* Noise blanker */
     status set_nb_on(int nbid, bool on);
@@ -172,6 +205,7 @@ public:
     status set_agc_manual_gain(int gain);
 
     status set_demod(rx_demod demod);
+    rx_demod get_demod() { return d_demod; }
 
     /* FM parameters */
     status set_fm_maxdev(float maxdev_hz);
@@ -198,22 +232,123 @@ public:
     status stop_sniffer();
     void   get_sniffer_data(float * outbuff, unsigned int &num);
 
+    /* additional channels (VFOs) */
+    int    add_channel(double offset_hz, rx_demod demod, const std::string wav_filename="");
+    status remove_channel(int id);
+    status set_channel_offset(int id, double offset_hz);
+    status set_channel_filter(int id, double low, double high, filter_shape shape);
+    status set_channel_sql_level(int id, double level_db);
+    float  get_channel_signal_pwr(int id, bool dbfs);
+    int    num_channels() { return (int) d_channels.size(); }
+    bool   has_channel(int id) { return find_channel(id) != 0; }
+
+    /* polyphase filterbank channelizer */
+    status start_channelizer(double spacing_hz);
+    status stop_channelizer();
+    bool   is_channelizer_active() { return d_pfb_nchans > 0; }
+    double get_channelizer_spacing();
+    int    get_channelizer_index(double offset_hz);
+    int    add_channelizer_channel(int index, rx_demod demod, const std::string wav_filename="");
+
+    /*! \brief Performance data of one block, see get_block_perf(). */
+    struct block_perf
+    {
+        std::string  name;        /*!< Block alias, e.g. rx_agc_cc12. */
+        double       work_time;   /*!< Average time per work() call in us. */
+        double       busy;        /*!< Fraction of time spent in work() since the previous call. */
+        double       throughput;  /*!< Items per second produced (consumed by sinks). */
+        float        in_full;     /*!< Average input buffer fullness (0 to 1), -1 if no inputs. */
+        float        out_full;    /*!< Average output buffer fullness (0 to 1), -1 if no outputs. */
+    };
+
+    void get_block_perf(std::vector<block_perf> &perf);
+    double get_dsp_load();
+
 private:
+    /*! \brief An additional demodulator sharing the I/Q source.
+     *
+     * Each channel has its own frequency offset and receiver and writes its
+     * audio to a WAV file, or to null sinks if no file name was given. The
+     * sound card is only used by the main receiver.
+     */
+    struct rx_channel
+    {
+        int                   id;        /*!< Channel ID returned by add_channel(). */
+        double                offset;    /*!< Frequency offset in Hz. */
+        int                   pfb_index; /*!< Channelizer output or -1 if using rotator. */
+        rx_rotator_cc_sptr    rotator;   /*!< Frequency shifter (rotator channels only). */
+        receiver_base_cf_sptr rx;        /*!< Demodulator chain. */
+        gr::basic_block_sptr  sink0;     /*!< Audio sink, left channel / WAV file. */
+        gr::basic_block_sptr  sink1;     /*!< Audio sink, right channel (null sink only). */
+        gr::blocks::wavfile_sink::sptr wav_sink; /*!< WAV recorder, if any. */
+    };
+
     void connect_all(rx_chain type);
+    bool create_channelizer();
+    unsigned int rebuild_channelizer();
+    void connect_channelizer();
+    void disconnect_channelizer();
+    int  create_channel(rx_channel &ch, double rate, rx_demod demod,
+                        const std::string &wav_filename);
+    void connect_channel(rx_channel &ch);
+    void disconnect_channel(rx_channel &ch);
+    rx_channel *find_channel(int id);
+    void connect_iq_chain();
+    gr::basic_block_sptr iq_output();
+    void update_quad_rate();
+    void update_iq_fft_period();
+    void get_blocks(std::vector<gr::basic_block_sptr> &blocks);
+    void prepare_device_worker(const std::string device);
+    void prepare_rate_worker(double rate);
+    void wait_input_prepared();
+
+    /*! \brief Counters of a block at the previous get_block_perf() call. */
+    struct perf_state
+    {
+        float                   work_total;  /*!< Total time spent in work() in ticks. */
+        uint64_t                nitems;      /*!< Items produced or consumed. */
+        gr::high_res_timer_type time;        /*!< Time of the snapshot. */
+    };
 
 private:
     bool   d_running;          /*!< Whether receiver is running or not. */
     double d_input_rate;       /*!< Input sample rate. */
+    double d_quad_rate;        /*!< Sample rate after input decimation. */
+    unsigned int d_decim;      /*!< Input decimation. */
     double d_audio_rate;       /*!< Audio output rate. */
     double d_rf_freq;          /*!< Current RF frequency. */
     double d_filter_offset;    /*!< Current filter offset (tune within passband). */
+    int    d_iq_fft_rate;      /*!< Baseband FFT display rate in fps. */
     bool   d_recording_wav;    /*!< Whether we are recording WAV file. */
     bool   d_sniffer_active;   /*!< Only one data decoder allowed. */
     bool   d_iq_rev;           /*!< Whether I/Q is reversed or not. */
     bool   d_dc_cancel;        /*!< Enable automatic DC removal. */
     bool   d_iq_balance;       /*!< Enable automatic IQ balance. */
-
-    std::string input_devstr;  /*!< Current input device string. */
+    int    d_next_channel_id;  /*!< ID of the next channel added. */
+    double d_reconf_time;      /*!< Lock time since reset_reconf_time() in ms. */
+
+    std::vector<rx_channel> d_channels; /*!< Additional channels. */
+
+    std::map<long, perf_state> d_perf_state; /*!< Per block counters, by unique ID. */
+    std::map<long, float>      d_load_totals; /*!< Work time totals at the previous get_dsp_load() call. */
+    gr::high_res_timer_type    d_load_time;   /*!< Time of the previous get_dsp_load() call, 0 if none. */
+
+    unsigned int d_pfb_nchans;     /*!< Number of channelizer outputs, 0 if inactive. */
+    double       d_pfb_spacing;    /*!< Requested channel spacing, 0 if inactive. */
+    gr::blocks::stream_to_streams::sptr      pfb_s2ss;   /*!< Channelizer input commutator. */
+    gr::filter::pfb_channelizer_ccf::sptr    pfb;        /*!< Polyphase filterbank channelizer. */
+    std::vector<gr::blocks::null_sink::sptr> pfb_null;   /*!< Sinks for all channelizer outputs. */
+
+    /* input change prepared by a worker, see prepare_input_device() */
+    boost::mutex              d_prep_mutex;  /*!< Protects d_prep_busy. */
+    boost::condition_variable d_prep_cond;   /*!< Signals a finished preparation. */
+    bool                      d_prep_busy;   /*!< A worker is preparing. */
+    osmosdr::source::sptr     d_prep_src;    /*!< Source opened by the worker, if any. */
+    std::string               d_prep_devstr; /*!< Device the worker opened. */
+    double                    d_prep_rate;   /*!< Rate the worker prepared, 0 if none. */
+    double                    d_prep_actual_rate; /*!< Rate set on the device by the worker. */
+
+        std::string input_devstr;  /*!< Current input device string. */
     std::string output_devstr; /*!< Current output device string. */
 
     rx_demod  d_demod;          /*!< Current demodulator. */
@@ -224,14 +359,13 @@ private:
     //rx_source_base::sptr       src;       /*!< Real time I/Q source. */
     receiver_base_cf_sptr     rx;        /*!< receiver. */
 
-    dc_corr_cc_sptr           dc_corr;   /*!< DC corrector block. */
-    iq_swap_cc_sptr           iq_swap;   /*!< I/Q swapping block. */
+    iq_condition_cc_sptr      iq_cond;   /*!< I/Q swap, DC and balance correction. */
+    fir_decim_cc_sptr         input_decim;  /*!< Input decimator (if d_decim > 1). */
 
     rx_fft_c_sptr             iq_fft;     /*!< Baseband FFT block. */
     rx_fft_f_sptr             audio_fft;  /*!< Audio FFT block. */
 
-    gr::analog::sig_source_c::sptr      lo;  /*!< oscillator used for tuning. */
-    gr::blocks::multiply_cc::sptr mixer;
+    rx_rotator_cc_sptr        rotator;    /*!< Frequency shifter used for tuning. */
 
     gr::blocks::multiply_const_ff::sptr audio_gain0; /*!< Audio gain block. */
     gr::blocks::multiply_const_ff::sptr audio_gain1; /*!< Audio gain block. */
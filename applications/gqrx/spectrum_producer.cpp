@@ -0,0 +1,137 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <QElapsedTimer>
+#include "applications/gqrx/receiver.h"
+#include "applications/gqrx/spectrum_producer.h"
+#include "dsp/rx_fft.h"
+
+
+static spectrum_frame empty_frame()
+{
+    spectrum_frame frame;
+
+    frame.fft.resize(MAX_FFT_SIZE);
+    frame.wf.resize(MAX_FFT_SIZE);
+    frame.size = 0;
+
+    return frame;
+}
+
+/*! \brief Create a new spectrum producer.
+ *  \param rx The receiver. Must outlive the producer thread.
+ *  \param parent The parent object.
+ *
+ * The thread is not started; use start() and stop().
+ */
+SpectrumProducer::SpectrumProducer(receiver *rx, QObject *parent)
+    : QThread(parent),
+      d_rx(rx),
+      d_frames(empty_frame()),
+      d_interval(0),
+      d_running(true),
+      d_pending(false)
+{
+}
+
+SpectrumProducer::~SpectrumProducer()
+{
+    stop();
+}
+
+/*! \brief Set frame rate.
+ *  \param fps The new frame rate in frames per second. 0 pauses the producer.
+ *
+ * Can be called from any thread, also while running.
+ */
+void SpectrumProducer::setRate(int fps)
+{
+    d_interval.store(fps > 0 ? 1000 / fps : 0);
+}
+
+/*! \brief Stop the thread and wait until it has exited.
+ *
+ * The thread can be started again with start().
+ */
+void SpectrumProducer::stop()
+{
+    d_running.store(false);
+    wait();
+    d_running.store(true);
+}
+
+/*! \brief Get the newest frame, if any.
+ *  \returns true if frame() now refers to a new frame.
+ *
+ * Must only be called from one thread (the GUI thread).
+ */
+bool SpectrumProducer::fetch()
+{
+    d_pending.store(false);
+
+    return d_frames.fetch();
+}
+
+/*! \brief The frame obtained by the last successful fetch(). */
+const spectrum_frame &SpectrumProducer::frame()
+{
+    return d_frames.read_buffer();
+}
+
+void SpectrumProducer::run()
+{
+    QElapsedTimer timer;
+    int interval;
+
+    timer.start();
+
+    while (d_running.load())
+    {
+        interval = d_interval.load();
+        if (interval == 0)
+        {
+            /* paused */
+            msleep(100);
+            timer.restart();
+            continue;
+        }
+
+        spectrum_frame &frame = d_frames.write_buffer();
+
+        /* spectra are shifted, scaled to dBFS and averaged in rx_fft_c */
+        d_rx->get_iq_fft_data(&frame.fft[0], &frame.wf[0], frame.size);
+        if (frame.size > 0)
+        {
+            d_frames.publish();
+            if (!d_pending.exchange(true))
+                emit newFrame();
+        }
+
+        /* keep a fixed frame rate independent of the processing time */
+        qint64 elapsed = timer.restart();
+        if (elapsed < interval)
+        {
+            msleep(interval - elapsed);
+            timer.restart();
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef SPECTRUM_PRODUCER_H
+#define SPECTRUM_PRODUCER_H
+
+#include <vector>
+#include <QThread>
+
+// see https://bugreports.qt-project.org/browse/QTBUG-22829
+#ifndef Q_MOC_RUN
+#include <boost/atomic.hpp>
+#include "dsp/triple_buffer.h"
+#endif
+
+class receiver;
+
+
+/*! \brief One baseband spectrum frame ready for plotting. */
+struct spectrum_frame
+{
+    std::vector<float> fft;   /*!< Averaged spectrum (pandapter). */
+    std::vector<float> wf;    /*!< Instantaneous spectrum (waterfall). */
+    unsigned int       size;  /*!< Number of valid points. */
+};
+
+/*! \brief Thread pulling baseband spectra from the receiver.
+ *
+ * The thread calls receiver::get_iq_fft_data() at the configured frame
+ * rate and hands finished frames to the GUI thread through a lock-free
+ * triple buffer. The FFT computation thus never waits for painting and
+ * painting never waits for the FFT.
+ *
+ * newFrame() is emitted with a queued connection at most once until the
+ * GUI has called fetch(), so a slow GUI does not accumulate events; it
+ * simply gets the newest frame when it is ready.
+ */
+class SpectrumProducer : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SpectrumProducer(receiver *rx, QObject *parent = 0);
+    ~SpectrumProducer();
+
+    void setRate(int fps);
+    void stop();
+
+    bool fetch();
+    const spectrum_frame &frame();
+
+signals:
+    /*! \brief A new frame is available via fetch(). */
+    void newFrame();
+
+protected:
+    void run();
+
+private:
+    receiver *d_rx;                          /*!< The receiver providing the spectra. */
+    triple_buffer<spectrum_frame> d_frames;  /*!< Frames handed to the GUI. */
+    boost::atomic<int>  d_interval;          /*!< Frame interval in ms, 0 = paused. */
+    boost::atomic<bool> d_running;           /*!< Thread should keep running. */
+    boost::atomic<bool> d_pending;           /*!< newFrame() emitted but not fetched. */
+};
+
+#endif // SPECTRUM_PRODUCER_H
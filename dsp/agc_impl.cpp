@@ -39,6 +39,8 @@
 
 #include <dsp/agc_impl.h>
 #include <math.h>
+#include <algorithm>
+#include <volk/volk.h>
 
 //////////////////////////////////////////////////////////////////////
 // Local Defines
@@ -71,6 +73,8 @@
 
 #define LOG_MAX_AMPL    log10f(MAX_AMPLITUDE)
 
+#define LOG10_2         0.30102999566f
+
 #define MIN_CONSTANT 1e-8   // const for calc log() so that a value of 0 magnitude == -8
                             // corresponding to -160dB.
                             // K = 10^(-8 + log(MAX_AMP))
@@ -102,6 +106,7 @@ CAgc::CAgc()
     m_Peak = 0.f;
     m_SigDelayPtr = 0;
     m_MagBufPos = 0;
+    m_PrefixMax = 0.f;
     m_DelaySamples = 0;
     m_WindowSamples = 0;
     m_HangTime = 0;
@@ -146,10 +151,12 @@ void CAgc::SetParameters(bool AgcOn,  bool UseHang, int Threshold, int ManualGai
         {
             m_SigDelayBuf[i] = 0.0;
             m_MagBuf[i] = -16.0;
+            m_SuffixMax[i] = -16.0;
         }
         m_SigDelayPtr = 0;
         m_HangTimer = 0;
         m_Peak = -16.0;
+        m_PrefixMax = -16.0;
         m_DecayAve = -5.0;
         m_AttackAve = -5.0;
         m_MagBufPos = 0;
@@ -181,135 +188,175 @@ void CAgc::SetParameters(bool AgcOn,  bool UseHang, int Threshold, int ManualGai
     m_DelaySamples = (int)(m_SampleRate * DELAY_TIMECONST);
     m_WindowSamples = (int)(m_SampleRate * WINDOW_TIMECONST);
 
-    // clamp Delay samples within buffer limit
+    // clamp Delay samples and peak window within buffer limit
     if (m_DelaySamples >= MAX_DELAY_BUF - 1)
         m_DelaySamples = MAX_DELAY_BUF - 1;
+    if (m_WindowSamples > MAX_DELAY_BUF)
+        m_WindowSamples = MAX_DELAY_BUF;
+    if (m_WindowSamples < 1)
+        m_WindowSamples = 1;
 }
 
 
 
 //////////////////////////////////////////////////////////////////////
-// Automatic Gain Control calculator for COMPLEX data
+// Convert the 'Length' magnitudes in m_Mag to log10 magnitudes.
+// Uses the VOLK log2 kernel on the whole chunk instead of one log10f()
+// per sample.
 //////////////////////////////////////////////////////////////////////
-void CAgc::ProcessData(int Length, const TYPECPX * pInData, TYPECPX * pOutData)
+void CAgc::LogMagnitudes(int Length)
+{
+    for (int i = 0; i < Length; i++)
+        m_Mag[i] += MIN_CONSTANT;
+
+    volk_32f_log2_32f(m_Mag, m_Mag, Length);
+    volk_32f_s32f_multiply_32f(m_Mag, m_Mag, LOG10_2, Length);
+
+    for (int i = 0; i < Length; i++)
+        m_Mag[i] -= LOG_MAX_AMPL;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Calculate the gains for the 'Length' log magnitudes in m_Mag and
+// store them in m_Gain. This part is shared by the complex and the
+// real data paths.
+//////////////////////////////////////////////////////////////////////
+void CAgc::CalcGains(int Length)
 {
-    float       gain;
     float       mag;
-    TYPECPX     delayedin;
 
-    if (m_AgcOn)
+    for (int i = 0; i < Length; i++)
     {
-        for (int i = 0; i < Length; i++)
+        mag = m_Mag[i];
+
+        // create a sliding window of 'm_WindowSamples' magnitudes and output the peak value
+        // within the sliding window: the window is the part of the previous block after
+        // m_MagBufPos plus the current block up to m_MagBufPos
+        m_MagBuf[m_MagBufPos] = mag;
+        m_PrefixMax = (m_MagBufPos == 0) ? mag : std::max(m_PrefixMax, mag);
+
+        if (m_MagBufPos == m_WindowSamples - 1)
         {
-            // get latest input sample
-            TYPECPX     in = pInData[i];
-
-            // Get delayed sample of input signal
-            delayedin = m_SigDelayBuf[m_SigDelayPtr];
-
-            // put new input sample into signal delay buffer
-            m_SigDelayBuf[m_SigDelayPtr++] = in;
-
-            // deal with delay buffer wrap around
-            if (m_SigDelayPtr >= m_DelaySamples)
-                m_SigDelayPtr = 0;
-
-            mag = fabs(in.real());
-            float mim = fabs(in.imag());
-            if (mim > mag)
-                mag = mim;
-            mag = log10f(mag + MIN_CONSTANT) - LOG_MAX_AMPL;
-
-            // create a sliding window of 'm_WindowSamples' magnitudes and output the peak value within the sliding window
-            float tmp = m_MagBuf[m_MagBufPos];   // get oldest mag sample from buffer into tmp
-            m_MagBuf[m_MagBufPos++] = mag;       // put latest mag sample in buffer;
-            if (m_MagBufPos >= m_WindowSamples)  // deal with magnitude buffer wrap around
-                m_MagBufPos = 0;
-            if (mag > m_Peak)
+            // block complete: the window is the current block, and its suffix
+            // maxima are needed while the next block is filled
+            m_Peak = m_PrefixMax;
+            float suffix = m_MagBuf[m_MagBufPos];
+            for (int k = m_MagBufPos; k >= 0; k--)
             {
-                m_Peak = mag;	//if new sample is larger than current peak then use it, no need to look at buffer values
+                suffix = std::max(suffix, m_MagBuf[k]);
+                m_SuffixMax[k] = suffix;
             }
+            m_MagBufPos = 0;
+        }
+        else
+        {
+            m_Peak = std::max(m_SuffixMax[m_MagBufPos + 1], m_PrefixMax);
+            m_MagBufPos++;
+        }
+
+        if (m_UseHang)
+        {
+            // using hang timer mode
+            if (m_Peak > m_AttackAve)
+                // if magnitude is rising (use m_AttackRiseAlpha time constant)
+                m_AttackAve = (1.0 - m_AttackRiseAlpha) * m_AttackAve +
+                              m_AttackRiseAlpha * m_Peak;
             else
-            {
-                if (tmp == m_Peak)    //tmp is oldest sample pulled out of buffer
-                {                     //if oldest sample pulled out was last peak then need to find next highest peak in buffer
-                    m_Peak = -8.0;    //set to lowest value to find next max peak
-                    //search all buffer for maximum value and set as new peak
-                    for (int i = 0; i < m_WindowSamples; i++)
-                    {
-                        tmp = m_MagBuf[i];
-                        if (tmp > m_Peak)
-                            m_Peak = tmp;
-                    }
-                }
-            }
+                // else magnitude is falling (use  m_AttackFallAlpha time constant)
+                m_AttackAve = (1.0 - m_AttackFallAlpha) * m_AttackAve +
+                              m_AttackFallAlpha * m_Peak;
 
-            if (m_UseHang)
+            if (m_Peak > m_DecayAve)
             {
-                // using hang timer mode
-                if (m_Peak > m_AttackAve)
-                    // if power is rising (use m_AttackRiseAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackRiseAlpha) * m_AttackAve +
-                                  m_AttackRiseAlpha * m_Peak;
-                else
-                    // else magnitude is falling (use  m_AttackFallAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackFallAlpha) * m_AttackAve +
-                                  m_AttackFallAlpha * m_Peak;
-
-                if (m_Peak > m_DecayAve)
-                {
-                    // if magnitude is rising (use m_DecayRiseAlpha time constant)
-                    m_DecayAve = (1.0 - m_DecayRiseAlpha) * m_DecayAve +
-                                  m_DecayRiseAlpha * m_Peak;
-                    // reset hang timer
-                    m_HangTimer = 0;
-                }
-                else
-                {	// here if decreasing signal
-                    if (m_HangTimer < m_HangTime)
-                        m_HangTimer++;	// just inc and hold current m_DecayAve
-                    else	// else decay with m_DecayFallAlpha which is RELEASE_TIMECONST
-                        m_DecayAve = (1.0 - m_DecayFallAlpha) * m_DecayAve +
-                                     m_DecayFallAlpha * m_Peak;
-                }
+                // if magnitude is rising (use m_DecayRiseAlpha time constant)
+                m_DecayAve = (1.0 - m_DecayRiseAlpha) * m_DecayAve +
+                             m_DecayRiseAlpha * m_Peak;
+                // reset hang timer
+                m_HangTimer = 0;
             }
             else
-            {
-                // using exponential decay mode
-                // perform average of magnitude using 2 averagers each with separate rise and fall time constants
-                if (m_Peak > m_AttackAve)	//if magnitude is rising (use m_AttackRiseAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackRiseAlpha) * m_AttackAve +
-                                  m_AttackRiseAlpha * m_Peak;
-                else
-                    // else magnitude is falling (use  m_AttackFallAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackFallAlpha) * m_AttackAve +
-                                  m_AttackFallAlpha * m_Peak;
-
-                if (m_Peak > m_DecayAve)
-                    // if magnitude is rising (use m_DecayRiseAlpha time constant)
-                    m_DecayAve = (1.0 - m_DecayRiseAlpha) * m_DecayAve +
-                                 m_DecayRiseAlpha * m_Peak;
-                else
-                    // else magnitude is falling (use m_DecayFallAlpha time constant)
+            {	// here if decreasing signal
+                if (m_HangTimer < m_HangTime)
+                    m_HangTimer++;	// just inc and hold current m_DecayAve
+                else	// else decay with m_DecayFallAlpha which is RELEASE_TIMECONST
                     m_DecayAve = (1.0 - m_DecayFallAlpha) * m_DecayAve +
                                  m_DecayFallAlpha * m_Peak;
             }
-
-            // use greater magnitude of attack or Decay Averager
-            if (m_AttackAve > m_DecayAve)
-                mag = m_AttackAve;
+        }
+        else
+        {
+            // using exponential decay mode
+            // perform average of magnitude using 2 averagers each with separate rise and fall time constants
+            if (m_Peak > m_AttackAve)	//if magnitude is rising (use m_AttackRiseAlpha time constant)
+                m_AttackAve = (1.0 - m_AttackRiseAlpha) * m_AttackAve +
+                              m_AttackRiseAlpha * m_Peak;
             else
-                mag = m_DecayAve;
-
-            // calc gain depending on which side of knee the magnitude is on
-            if (mag <= m_Knee)
-                // use fixed gain if below knee
-                gain = m_FixedGain;
+                // else magnitude is falling (use  m_AttackFallAlpha time constant)
+                m_AttackAve = (1.0 - m_AttackFallAlpha) * m_AttackAve +
+                              m_AttackFallAlpha * m_Peak;
+
+            if (m_Peak > m_DecayAve)
+                // if magnitude is rising (use m_DecayRiseAlpha time constant)
+                m_DecayAve = (1.0 - m_DecayRiseAlpha) * m_DecayAve +
+                             m_DecayRiseAlpha * m_Peak;
             else
-                // use variable gain if above knee
-                gain = AGC_OUTSCALE * powf(10.0, mag * (m_GainSlope - 1.0));
+                // else magnitude is falling (use m_DecayFallAlpha time constant)
+                m_DecayAve = (1.0 - m_DecayFallAlpha) * m_DecayAve +
+                             m_DecayFallAlpha * m_Peak;
+        }
+
+        // use greater magnitude of attack or Decay Averager
+        if (m_AttackAve > m_DecayAve)
+            mag = m_AttackAve;
+        else
+            mag = m_DecayAve;
+
+        // calc gain depending on which side of knee the magnitude is on
+        if (mag <= m_Knee)
+            // use fixed gain if below knee
+            m_Gain[i] = m_FixedGain;
+        else
+            // use variable gain if above knee
+            m_Gain[i] = AGC_OUTSCALE * powf(10.0, mag * (m_GainSlope - 1.0));
+    }
+}
 
-            pOutData[i] = delayedin * gain;
+//////////////////////////////////////////////////////////////////////
+// Automatic Gain Control calculator for COMPLEX data
+//////////////////////////////////////////////////////////////////////
+void CAgc::ProcessData(int Length, const TYPECPX * pInData, TYPECPX * pOutData)
+{
+    TYPECPX     delayedin;
+
+    if (m_AgcOn)
+    {
+        for (int j = 0; j < Length; j += AGC_CHUNK)
+        {
+            int n = std::min(Length - j, AGC_CHUNK);
+            const TYPECPX *in = pInData + j;
+            TYPECPX *out = pOutData + j;
+
+            // magnitude is the larger of |I| and |Q|
+            for (int i = 0; i < n; i++)
+                m_Mag[i] = std::max(fabsf(in[i].real()), fabsf(in[i].imag()));
+
+            LogMagnitudes(n);
+            CalcGains(n);
+
+            for (int i = 0; i < n; i++)
+            {
+                // Get delayed sample of input signal
+                delayedin = m_SigDelayBuf[m_SigDelayPtr];
+
+                // put new input sample into signal delay buffer
+                m_SigDelayBuf[m_SigDelayPtr++] = in[i];
+
+                // deal with delay buffer wrap around
+                if (m_SigDelayPtr >= m_DelaySamples)
+                    m_SigDelayPtr = 0;
+
+                out[i] = delayedin * m_Gain[i];
+            }
         }
     }
     else
@@ -327,119 +374,34 @@ void CAgc::ProcessData(int Length, const TYPECPX * pInData, TYPECPX * pOutData)
 //////////////////////////////////////////////////////////////////////
 void CAgc::ProcessData(int Length, const float *pInData, float * pOutData)
 {
-    float       gain;
-    float       mag;
     float       delayedin;
 
     if (m_AgcOn)
     {
-        for (int i = 0; i < Length; i++)
+        for (int j = 0; j < Length; j += AGC_CHUNK)
         {
-            // get latest input sample
-            float in = pInData[i];
-
-            // Get delayed sample of input signal
-            delayedin = m_SigDelayBuf_r[m_SigDelayPtr];
-
-            // put new input sample into signal delay buffer
-            m_SigDelayBuf_r[m_SigDelayPtr++] = in;
-            if (m_SigDelayPtr >= m_DelaySamples) //deal with delay buffer wrap around
-                m_SigDelayPtr = 0;
-
-            // convert |mag| to log |mag|
-            mag = log10f(fabs(in) + MIN_CONSTANT) - LOG_MAX_AMPL;
-
-            // create a sliding window of 'm_WindowSamples' magnitudes and output the peak value within the sliding window
-            float tmp = m_MagBuf[m_MagBufPos];   // get oldest mag sample from buffer into tmp
-            m_MagBuf[m_MagBufPos++] = mag;       // put latest mag sample in buffer;
-            if (m_MagBufPos >= m_WindowSamples)  // deal with magnitude buffer wrap around
-                m_MagBufPos = 0;
-            if (mag > m_Peak)
-            {
-                m_Peak = mag;  // if new sample is larger than current peak then use it, no need to look at buffer values
-            }
-            else
-            {
-                if (tmp == m_Peak)   // tmp is oldest sample pulled out of buffer
-                {                    // if oldest sample pulled out was last peak then need to find next highest peak in buffer
-                    m_Peak = -8.0;   // set to lowest value to find next max peak
-                    // search all buffer for maximum value and set as new peak
-                    for (int i = 0; i < m_WindowSamples; i++)
-                    {
-                        tmp = m_MagBuf[i];
-                        if (tmp > m_Peak)
-                            m_Peak = tmp;
-                    }
-                }
-            }
+            int n = std::min(Length - j, AGC_CHUNK);
+            const float *in = pInData + j;
+            float *out = pOutData + j;
 
-            if (m_UseHang)
-            {
-                // using hang timer mode
-                if (m_Peak > m_AttackAve)
-                    // if magnitude is rising (use m_AttackRiseAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackRiseAlpha) * m_AttackAve +
-                                  m_AttackRiseAlpha * m_Peak;
-                else
-                    // else magnitude is falling (use  m_AttackFallAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackFallAlpha) * m_AttackAve +
-                                  m_AttackFallAlpha * m_Peak;
-
-                if (m_Peak > m_DecayAve)
-                {
-                    // if magnitude is rising (use m_DecayRiseAlpha time constant)
-                    m_DecayAve = (1.0 - m_DecayRiseAlpha) * m_DecayAve +
-                                 m_DecayRiseAlpha*m_Peak;
-                    m_HangTimer = 0; // reset hang timer
-                }
-                else
-                {
-                    // here if decreasing signal
-                    if (m_HangTimer < m_HangTime)
-                        m_HangTimer++; // just inc and hold current m_DecayAve
-                    else
-                        // else decay with m_DecayFallAlpha which is RELEASE_TIMECONST
-                        m_DecayAve = (1.0 - m_DecayFallAlpha) * m_DecayAve +
-                                     m_DecayFallAlpha * m_Peak;
-                }
-            }
-            else
+            for (int i = 0; i < n; i++)
+                m_Mag[i] = fabsf(in[i]);
+
+            LogMagnitudes(n);
+            CalcGains(n);
+
+            for (int i = 0; i < n; i++)
             {
-                // using exponential decay mode
-                // perform average of magnitude using 2 averagers each with separate rise and fall time constants
-                if (m_Peak > m_AttackAve)
-                    // if magnitude is rising (use m_AttackRiseAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackRiseAlpha) * m_AttackAve +
-                                  m_AttackRiseAlpha * m_Peak;
-                else
-                    // else magnitude is falling (use  m_AttackFallAlpha time constant)
-                    m_AttackAve = (1.0 - m_AttackFallAlpha) * m_AttackAve +
-                                  m_AttackFallAlpha * m_Peak;
-
-                if (m_Peak > m_DecayAve)
-                    // if magnitude is rising (use m_DecayRiseAlpha time constant)
-                    m_DecayAve = (1.0 - m_DecayRiseAlpha) * m_DecayAve +
-                                 m_DecayRiseAlpha * m_Peak;
-                else
-                    // else magnitude is falling (use m_DecayFallAlpha time constant)
-                    m_DecayAve = (1.0 - m_DecayFallAlpha) * m_DecayAve +
-                                 m_DecayFallAlpha * m_Peak;
-            }
+                // Get delayed sample of input signal
+                delayedin = m_SigDelayBuf_r[m_SigDelayPtr];
 
-            // use greater magnitude of attack or Decay Averager
-            if (m_AttackAve > m_DecayAve)
-                mag = m_AttackAve;
-            else
-                mag = m_DecayAve;
+                // put new input sample into signal delay buffer
+                m_SigDelayBuf_r[m_SigDelayPtr++] = in[i];
+                if (m_SigDelayPtr >= m_DelaySamples) //deal with delay buffer wrap around
+                    m_SigDelayPtr = 0;
 
-            // calc gain depending on which side of knee the magnitude is on
-            if (mag <= m_Knee)
-                // use fixed gain if below knee
-                gain = m_FixedGain;
-            else
-                // use variable gain if above knee
-                gain = AGC_OUTSCALE * powf(10.0, mag * (m_GainSlope - 1.0));
-            pOutData[i] = delayedin * gain;
+                out[i] = delayedin * m_Gain[i];
+            }
         }
     }
     else
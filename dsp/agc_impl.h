@@ -7,6 +7,7 @@
 //  2010-09-15  Initial creation MSW
 //  2011-03-27  Initial release
 //  2011-09-24  Adapted for gqrx
+//  2026-10-17  Sliding window peak in O(1) per sample, block-wise log
 //////////////////////////////////////////////////////////////////////
 #ifndef AGC_IMPL_H
 #define AGC_IMPL_H
@@ -14,6 +15,7 @@
 #include <complex>
 
 #define MAX_DELAY_BUF 2048
+#define AGC_CHUNK 256
 
 /*
 typedef struct _dCplx
@@ -38,6 +40,9 @@ public:
     void ProcessData(int Length, const float * pInData, float * pOutData);
 
 private:
+    void LogMagnitudes(int Length);
+    void CalcGains(int Length);
+
     bool        m_AgcOn;
     bool        m_UseHang;
     int         m_Threshold;
@@ -72,7 +77,17 @@ private:
     TYPECPX     m_SigDelayBuf[MAX_DELAY_BUF];
     float*      m_SigDelayBuf_r;
 
+    // sliding window maximum of the log magnitudes (van Herk / Gil-Werman):
+    // the window is split into blocks of m_WindowSamples; m_PrefixMax is the
+    // maximum of the current block so far and m_SuffixMax holds the suffix
+    // maxima of the previous block
     float       m_MagBuf[MAX_DELAY_BUF];
+    float       m_SuffixMax[MAX_DELAY_BUF];
+    float       m_PrefixMax;
+
+    // per chunk magnitudes and gains
+    float       m_Mag[AGC_CHUNK];
+    float       m_Gain[AGC_CHUNK];
 };
 
 #endif //  AGC_IMPL_H
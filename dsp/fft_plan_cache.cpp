@@ -0,0 +1,215 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+#include <boost/thread/tss.hpp>
+#include <gnuradio/fft/fft.h>
+#include "dsp/fft_plan_cache.h"
+
+
+/*! \brief Non-NULL on threads that called mark_dsp_thread(). */
+static boost::thread_specific_ptr<bool> dsp_thread_flag;
+
+/*! \brief Mark the calling thread as a GNU Radio scheduler thread.
+ *
+ * Cheap enough to be called at the top of every work() call; the flag
+ * is only allocated the first time on each thread.
+ */
+void fft_plan_cache::mark_dsp_thread()
+{
+    if (dsp_thread_flag.get() == NULL)
+        dsp_thread_flag.reset(new bool(true));
+}
+
+/*! \brief Check whether the calling thread has been marked as a DSP thread. */
+bool fft_plan_cache::is_dsp_thread()
+{
+    return dsp_thread_flag.get() != NULL;
+}
+
+
+/*! \brief Get the plan map.
+ *
+ * Function-local static so that the map is constructed on first use.
+ * Access must be protected by the GNU Radio planner mutex.
+ */
+fft_plan_cache::plan_map &fft_plan_cache::plans()
+{
+    static plan_map map;
+
+    return map;
+}
+
+/*! \brief Get a plan from the cache, creating it if necessary.
+ *  \param size The FFT size.
+ *  \param type The transform type.
+ *  \return The FFTW plan. The plan is owned by the cache and must not be
+ *          destroyed by the caller.
+ *  \throws std::runtime_error if FFTW can not create the plan.
+ *
+ * Must not be called from a GNU Radio scheduler thread. If it is anyway,
+ * an error is printed and the new plan is created from wisdom or with
+ * FFTW_ESTIMATE, which takes microseconds instead of the hundreds of
+ * milliseconds FFTW_MEASURE may need. Such a plan stays in the cache for
+ * the rest of the session.
+ */
+fftwf_plan fft_plan_cache::get_plan(int size, plan_type type)
+{
+    gr::fft::planner::scoped_lock lock(gr::fft::planner::mutex());
+    std::pair<int, int> key(size, (int)type);
+    plan_map::iterator it = plans().find(key);
+
+    if (it != plans().end())
+        return it->second;
+
+    /* plan on private buffers; FFTW_MEASURE overwrites them */
+    fftwf_complex *in = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex)*size);
+    fftwf_complex *out = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex)*size);
+    fftwf_plan plan = NULL;
+    bool late = is_dsp_thread();
+    int dir = (type == PLAN_C2C_FWD) ? FFTW_FORWARD : FFTW_BACKWARD;
+
+    if (late)
+    {
+        std::cerr << "fft_plan_cache: size " << size
+                  << " requested from a DSP thread, using FFTW_ESTIMATE"
+                  << std::endl;
+
+        /* wisdom-only planning fails immediately if there is no wisdom */
+        if (type == PLAN_R2C)
+            plan = fftwf_plan_dft_r2c_1d(size, (float *) in, out,
+                                         FFTW_MEASURE | FFTW_WISDOM_ONLY);
+        else
+            plan = fftwf_plan_dft_1d(size, in, out, dir,
+                                     FFTW_MEASURE | FFTW_WISDOM_ONLY);
+    }
+
+    if (plan == NULL)
+    {
+        unsigned int flags = late ? FFTW_ESTIMATE : FFTW_MEASURE;
+
+        if (type == PLAN_R2C)
+            plan = fftwf_plan_dft_r2c_1d(size, (float *) in, out, flags);
+        else
+            plan = fftwf_plan_dft_1d(size, in, out, dir, flags);
+    }
+    fftwf_free(in);
+    fftwf_free(out);
+
+    if (plan == NULL)
+        throw std::runtime_error("fft_plan_cache: could not create FFTW plan");
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    std::cout << "fft_plan_cache: new plan size " << size << " type " << type << std::endl;
+#endif
+
+    plans()[key] = plan;
+
+    return plan;
+}
+
+/*! \brief Load FFTW wisdom from file.
+ *  \param filename The wisdom file.
+ *  \return true if the wisdom was loaded.
+ *
+ * Should be called at startup before the first FFT object is created.
+ */
+bool fft_plan_cache::load_wisdom(const std::string &filename)
+{
+    gr::fft::planner::scoped_lock lock(gr::fft::planner::mutex());
+    bool ok = fftwf_import_wisdom_from_filename(filename.c_str()) != 0;
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    std::cout << (ok ? "Loaded" : "Could not load")
+              << " FFTW wisdom from " << filename << std::endl;
+#endif
+
+    return ok;
+}
+
+/*! \brief Save FFTW wisdom to file.
+ *  \param filename The wisdom file.
+ *  \return true if the wisdom was saved.
+ */
+bool fft_plan_cache::save_wisdom(const std::string &filename)
+{
+    gr::fft::planner::scoped_lock lock(gr::fft::planner::mutex());
+
+    return fftwf_export_wisdom_to_filename(filename.c_str()) != 0;
+}
+
+
+/*! \brief Create a new FFT object.
+ *  \param fft_size The FFT size.
+ *  \param forward Forward or reverse transform.
+ */
+fft_complex_cached::fft_complex_cached(int fft_size, bool forward)
+    : d_fft_size(fft_size)
+{
+    d_plan = fft_plan_cache::get_plan(fft_size, forward ?
+                                      fft_plan_cache::PLAN_C2C_FWD :
+                                      fft_plan_cache::PLAN_C2C_REV);
+
+    d_inbuf = (gr_complex *) fftwf_malloc(sizeof(gr_complex)*fft_size);
+    d_outbuf = (gr_complex *) fftwf_malloc(sizeof(gr_complex)*fft_size);
+    memset(d_inbuf, 0, sizeof(gr_complex)*fft_size);
+}
+
+fft_complex_cached::~fft_complex_cached()
+{
+    fftwf_free(d_inbuf);
+    fftwf_free(d_outbuf);
+}
+
+/*! \brief Compute FFT of the data in the input buffer. */
+void fft_complex_cached::execute()
+{
+    fftwf_execute_dft(d_plan, (fftwf_complex *) d_inbuf, (fftwf_complex *) d_outbuf);
+}
+
+
+/*! \brief Create a new real-input FFT object.
+ *  \param fft_size The FFT size (number of real input samples).
+ */
+fft_real_cached::fft_real_cached(int fft_size)
+    : d_fft_size(fft_size)
+{
+    d_plan = fft_plan_cache::get_plan(fft_size, fft_plan_cache::PLAN_R2C);
+
+    d_inbuf = (float *) fftwf_malloc(sizeof(float)*fft_size);
+    d_outbuf = (gr_complex *) fftwf_malloc(sizeof(gr_complex)*(fft_size/2+1));
+    memset(d_inbuf, 0, sizeof(float)*fft_size);
+}
+
+fft_real_cached::~fft_real_cached()
+{
+    fftwf_free(d_inbuf);
+    fftwf_free(d_outbuf);
+}
+
+/*! \brief Compute FFT of the data in the input buffer. */
+void fft_real_cached::execute()
+{
+    fftwf_execute_dft_r2c(d_plan, d_inbuf, (fftwf_complex *) d_outbuf);
+}
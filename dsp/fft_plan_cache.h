@@ -0,0 +1,143 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef FFT_PLAN_CACHE_H
+#define FFT_PLAN_CACHE_H
+
+#include <map>
+#include <string>
+#include <fftw3.h>
+#include <gnuradio/gr_complex.h>
+
+
+/*! \brief Process-wide cache of FFTW plans.
+ *  \ingroup DSP
+ *
+ * Plans are created once per size and type and kept for the lifetime of
+ * the process. They are planned on private buffers and executed with the
+ * FFTW "new-array" interface, so any number of FFT objects of the same
+ * size can share a plan. All buffers must be allocated with fftwf_malloc()
+ * to get the same alignment as the planning buffers.
+ *
+ * Planning is serialized with the GNU Radio FFT planner mutex so that it
+ * does not race with FFT objects created by GNU Radio blocks.
+ *
+ * FFTW wisdom can be loaded at startup and saved at exit so that the
+ * expensive FFTW_MEASURE planning is only done once per machine.
+ *
+ * get_plan() must never be called from a GNU Radio scheduler thread:
+ * FFTW_MEASURE planning can take hundreds of milliseconds while holding
+ * the global planner mutex. FFT objects used in work() must be created
+ * by the setters and handed over to the scheduler thread. Blocks that
+ * use cached FFTs call mark_dsp_thread() at the top of work(); if such a
+ * thread still ends up in get_plan() the error is reported and the plan
+ * falls back to FFTW_ESTIMATE (or wisdom, if available).
+ */
+class fft_plan_cache
+{
+public:
+    /*! \brief Supported transform types. */
+    enum plan_type {
+        PLAN_C2C_FWD = 0,  /*!< Complex to complex, forward. */
+        PLAN_C2C_REV = 1,  /*!< Complex to complex, reverse. */
+        PLAN_R2C     = 2   /*!< Real to complex, forward (size/2+1 outputs). */
+    };
+
+    static fftwf_plan get_plan(int size, plan_type type);
+
+    static void mark_dsp_thread();
+    static bool is_dsp_thread();
+
+    static bool load_wisdom(const std::string &filename);
+    static bool save_wisdom(const std::string &filename);
+
+private:
+    typedef std::map<std::pair<int, int>, fftwf_plan> plan_map;
+
+    static plan_map &plans();
+};
+
+
+/*! \brief Complex FFT using plans from fft_plan_cache.
+ *  \ingroup DSP
+ *
+ * Drop-in replacement for gr::fft::fft_complex that does not create a new
+ * FFTW plan every time it is instantiated.
+ */
+class fft_complex_cached
+{
+public:
+    fft_complex_cached(int fft_size, bool forward = true);
+    ~fft_complex_cached();
+
+    gr_complex *get_inbuf() const { return d_inbuf; }
+    gr_complex *get_outbuf() const { return d_outbuf; }
+
+    int inbuf_length() const { return d_fft_size; }
+    int outbuf_length() const { return d_fft_size; }
+
+    void execute();
+
+private:
+    int          d_fft_size;  /*! FFT size. */
+    gr_complex  *d_inbuf;     /*! Input buffer (fftwf_malloc). */
+    gr_complex  *d_outbuf;    /*! Output buffer (fftwf_malloc). */
+    fftwf_plan   d_plan;      /*! Shared plan, owned by fft_plan_cache. */
+
+    /* not copyable */
+    fft_complex_cached(const fft_complex_cached &);
+    fft_complex_cached &operator=(const fft_complex_cached &);
+};
+
+
+/*! \brief Real-input FFT using plans from fft_plan_cache.
+ *  \ingroup DSP
+ *
+ * Computes the non-negative frequency half of the spectrum, i.e.
+ * fft_size/2+1 complex outputs for fft_size real inputs.
+ */
+class fft_real_cached
+{
+public:
+    fft_real_cached(int fft_size);
+    ~fft_real_cached();
+
+    float *get_inbuf() const { return d_inbuf; }
+    gr_complex *get_outbuf() const { return d_outbuf; }
+
+    int inbuf_length() const { return d_fft_size; }
+    int outbuf_length() const { return d_fft_size / 2 + 1; }
+
+    void execute();
+
+private:
+    int          d_fft_size;  /*! FFT size. */
+    float       *d_inbuf;     /*! Input buffer (fftwf_malloc). */
+    gr_complex  *d_outbuf;    /*! Output buffer (fftwf_malloc). */
+    fftwf_plan   d_plan;      /*! Shared plan, owned by fft_plan_cache. */
+
+    /* not copyable */
+    fft_real_cached(const fft_real_cached &);
+    fft_real_cached &operator=(const fft_real_cached &);
+};
+
+#endif /* FFT_PLAN_CACHE_H */
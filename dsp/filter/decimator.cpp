@@ -12,13 +12,24 @@
  */
 #include <gnuradio/gr_complex.h>
 #include <stdio.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HBF_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HBF_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
 
 #include "decimator.h"
 #include "filtercoef_hbf_70.h"
 #include "filtercoef_hbf_100.h"
 #include "filtercoef_hbf_140.h"
 
-#define MAX_HALF_BAND_BUFSIZE 32768
+#define MIN_HALF_BAND_BUFSIZE 16384
 #define DECIM_IS_POWER_OF_2(x)        ((x != 0) && ((x & (~x + 1)) == x))
 
 Decimator::Decimator()
@@ -65,16 +76,29 @@ unsigned int Decimator::init(unsigned int _decim, unsigned int _att)
     return decim;
 }
 
-int Decimator::process(int samples, gr_complex * pin, gr_complex * pout)
+/*
+ * Decimate samples from pin into pout.
+ * The first stage writes to the work buffer and the remaining stages run
+ * in place there, so pin is left untouched and pout only needs to hold
+ * samples / decim outputs.
+ */
+int Decimator::process(int samples, const gr_complex * pin, gr_complex * pout)
 {
     int         i = 0;
     int         n = samples;
 
+    if (!filter_table[0])
+        return 0;
+
+    if ((int)buf.size() < samples / 2)
+        buf.resize(samples / 2);
+
+    n = filter_table[i++]->DecBy2(n, pin, &buf[0]);
     while (filter_table[i])
-        n = filter_table[i++]->DecBy2(n, pin, pin);
+        n = filter_table[i++]->DecBy2(n, &buf[0], &buf[0]);
 
     for(i = 0; i < n; i++)
-        pout[i] = pin[i];
+        pout[i] = buf[i];
 
     return n;
 }
@@ -101,8 +125,8 @@ int Decimator::init_filters_70(unsigned int decimation)
     {
         if (decimation >= 4)
         {
-            filter_table[n++] = new CHalfBand11TapDecimateBy2(HBF_70_11);
-            fprintf(stderr, "  DEC %d: HBF_70_11 (unrolled)\n", n);
+            filter_table[n++] = new CHalfBandDecimateBy2(HBF_70_11_LENGTH, HBF_70_11);
+            fprintf(stderr, "  DEC %d: HBF_70_11\n", n);
         }
         else if (decimation == 2)
         {
@@ -124,8 +148,8 @@ int Decimator::init_filters_100(unsigned int decimation)
     {
         if (decimation >= 8)
         {
-            filter_table[n++] = new CHalfBand11TapDecimateBy2(HBF_100_11);
-            fprintf(stderr, "  DEC %d: HBF_100_11 (unrolled)\n", n);
+            filter_table[n++] = new CHalfBandDecimateBy2(HBF_100_11_LENGTH, HBF_100_11);
+            fprintf(stderr, "  DEC %d: HBF_100_11\n", n);
         }
         else if (decimation == 4)
         {
@@ -152,8 +176,8 @@ int Decimator::init_filters_140(unsigned int decimation)
     {
         if (decimation >= 16)
         {
-            filter_table[n++] = new CHalfBand11TapDecimateBy2(HBF_140_11);
-            fprintf(stderr, "  DEC %d: HBF_140_11 (unrolled)\n", n);
+            filter_table[n++] = new CHalfBandDecimateBy2(HBF_140_11_LENGTH, HBF_140_11);
+            fprintf(stderr, "  DEC %d: HBF_140_11\n", n);
         }
         else if (decimation == 8)
         {
@@ -177,164 +201,169 @@ int Decimator::init_filters_140(unsigned int decimation)
     return (1 << n);
 }
 
-Decimator::CHalfBandDecimateBy2::CHalfBandDecimateBy2(int len, const float * pCoef)
-    : m_FirLength(len), m_pCoef(pCoef)
+/*
+ * Scalar half-band kernel.
+ */
+static void hbf_kernel_generic(gr_complex * out, const gr_complex * even,
+                               const gr_complex * odd, int nout,
+                               const float * coef, int npairs, float center)
 {
-    gr_complex  CPXZERO(0.0,0.0);
+    const float *e = (const float *) even;
+    const float *o = (const float *) odd;
+    float       *y = (float *) out;
+    int          last = 2 * npairs - 1;
+    int          n, p;
 
-    // create buffer for FIR implementation
-    m_pHBFirBuf = new gr_complex[MAX_HALF_BAND_BUFSIZE];
-    for (int i = 0; i < MAX_HALF_BAND_BUFSIZE; i++)
-        m_pHBFirBuf[i] = CPXZERO;
+    for (n = 0; n < nout; n++)
+    {
+        float   re = center * o[2*n];
+        float   im = center * o[2*n+1];
+
+        for (p = 0; p < npairs; p++)
+        {
+            re += coef[p] * (e[2*(n+p)] + e[2*(n+last-p)]);
+            im += coef[p] * (e[2*(n+p)+1] + e[2*(n+last-p)+1]);
+        }
+        y[2*n] = re;
+        y[2*n+1] = im;
+    }
 }
 
+#ifdef HBF_HAVE_AVX2
 /*
- * Half band filter and decimate by 2 function.
- * Two restrictions on this routine:
- * InLength must be larger or equal to the Number of Halfband Taps
- * InLength must be an even number
+ * AVX2 + FMA half-band kernel; 4 complex outputs per iteration.
  */
-int Decimator::CHalfBandDecimateBy2::DecBy2(int InLength, gr_complex * pInData,
-                                            gr_complex * pOutData)
+__attribute__((target("avx2,fma")))
+static void hbf_kernel_avx2(gr_complex * out, const gr_complex * even,
+                            const gr_complex * odd, int nout,
+                            const float * coef, int npairs, float center)
 {
-    gr_complex     acc;
-    int     i;
-    int     j;
-    int     numoutsamples = 0;
-
-    // copy input samples into buffer starting at position m_FirLength-1
-    for (i = 0, j = m_FirLength - 1; i < InLength; i++)
-        m_pHBFirBuf[j++] = pInData[i];
+    int         last = 2 * npairs - 1;
+    int         n, p;
+    __m256      c = _mm256_set1_ps(center);
 
-    // perform decimation FIR filter on even samples
-    for (i = 0; i < InLength; i += 2)
+    for (n = 0; n + 4 <= nout; n += 4)
     {
-        acc = m_pHBFirBuf[i] * m_pCoef[0];
-        for (j = 0; j < m_FirLength; j += 2)
-            acc += m_pHBFirBuf[i+j] * m_pCoef[j];
+        __m256  acc = _mm256_mul_ps(c, _mm256_loadu_ps((const float *) &odd[n]));
 
-        // center coefficient
-        acc += m_pHBFirBuf[i+(m_FirLength-1)/2] * m_pCoef[(m_FirLength-1)/2];
-        pOutData[numoutsamples++] = acc;
+        for (p = 0; p < npairs; p++)
+        {
+            __m256  s = _mm256_add_ps(_mm256_loadu_ps((const float *) &even[n+p]),
+                                      _mm256_loadu_ps((const float *) &even[n+last-p]));
+            acc = _mm256_fmadd_ps(_mm256_set1_ps(coef[p]), s, acc);
+        }
+        _mm256_storeu_ps((float *) &out[n], acc);
     }
 
-    // need to copy last m_FirLength - 1 input samples in buffer to beginning of buffer
-    // for FIR wrap around management
-    for (i = 0, j = InLength - m_FirLength + 1; i < m_FirLength - 1; i++)
-        m_pHBFirBuf[i] = pInData[j++];
-
-    return numoutsamples;
+    if (n < nout)
+        hbf_kernel_generic(&out[n], &even[n], &odd[n], nout - n, coef, npairs, center);
 }
+#endif
 
+#ifdef HBF_HAVE_NEON
 /*
- * Decimate by 2 Fixed 11 Tap Halfband filter class implementation
+ * NEON half-band kernel; 2 complex outputs per iteration.
  */
-Decimator::CHalfBand11TapDecimateBy2::CHalfBand11TapDecimateBy2(const float * coef)
+static void hbf_kernel_neon(gr_complex * out, const gr_complex * even,
+                            const gr_complex * odd, int nout,
+                            const float * coef, int npairs, float center)
 {
-    gr_complex     CPXZERO(0.0, 0.0);
-
-    // preload only the taps that are used since evey other one is zero
-    // except center tap 5
-    H0 = coef[0];
-    H2 = coef[2];
-    H4 = coef[4];
-    H5 = coef[5];
-    H6 = coef[6];
-    H8 = coef[8];
-    H10 = coef[10];
-
-    d0 = CPXZERO;
-    d1 = CPXZERO;
-    d2 = CPXZERO;
-    d3 = CPXZERO;
-    d4 = CPXZERO;
-    d5 = CPXZERO;
-    d6 = CPXZERO;
-    d7 = CPXZERO;
-    d8 = CPXZERO;
-    d9 = CPXZERO;
+    int         last = 2 * npairs - 1;
+    int         n, p;
+
+    for (n = 0; n + 2 <= nout; n += 2)
+    {
+        float32x4_t acc = vmulq_n_f32(vld1q_f32((const float *) &odd[n]), center);
+
+        for (p = 0; p < npairs; p++)
+        {
+            float32x4_t s = vaddq_f32(vld1q_f32((const float *) &even[n+p]),
+                                      vld1q_f32((const float *) &even[n+last-p]));
+            acc = vmlaq_n_f32(acc, s, coef[p]);
+        }
+        vst1q_f32((float *) &out[n], acc);
+    }
+
+    if (n < nout)
+        hbf_kernel_generic(&out[n], &even[n], &odd[n], nout - n, coef, npairs, center);
 }
+#endif
 
 /*
- * Decimate by 2 Fixed 11 Tap Halfband filter class implementation
- * Two restrictions on this routine:
- * InLength must be larger or equal to the Number of Halfband Taps(11)
- * InLength must be an even number
- * Loop unrolled for speed
+ * Select the fastest kernel supported by the CPU.
  */
-int Decimator::CHalfBand11TapDecimateBy2::DecBy2(int InLength,
-                                                 gr_complex * pInData,
-                                                 gr_complex * pOutData)
+static Decimator::HbfKernel hbf_select_kernel(void)
 {
-    // calculate first 10 samples using previous samples in delay buffer
-    gr_complex     tmpout[9];
-
-    tmpout[0] = H0 * d0 + H2 * d2 + H4 * d4 + H5 * d5 + H6 * d6 + H8 * d8
-            + H10 * pInData[0];
-
-    tmpout[1] = H0 * d2 + H2 * d4 + H4 * d6 + H5 * d7 + H6 * d8
-            + H8 * pInData[0] + H10 * pInData[2];
-
-    tmpout[2] = H0 * d4 + H2 * d6 + H4 * d8 + H5 * d9 + H6 * pInData[0]
-            + H8 * pInData[2] + H10 * pInData[4];
+#ifdef HBF_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return hbf_kernel_avx2;
+#endif
+#ifdef HBF_HAVE_NEON
+    return hbf_kernel_neon;
+#endif
+    return hbf_kernel_generic;
+}
 
-    tmpout[3] = H0 * d6 + H2 * d8 + H4 * pInData[0] + H5 * pInData[1]
-            + H6 * pInData[2] + H8 * pInData[4] + H10 * pInData[6];
+/*
+ * The filter length must be 4k+3 (all half-band filters in
+ * filtercoef_hbf_*.h are). With L = 4k+3 the non-zero taps are the
+ * even taps 0, 2, .. L-1 and the center tap 2k+1. Output n is
+ *
+ *   y[n] = sum_{p=0..k} h[2p] * (x[2n+2p-L+1] + x[2n-2p]) + h[2k+1] * x[2n-2k-1]
+ *
+ * so we keep 2k+1 even and k+1 odd samples of history.
+ */
+Decimator::CHalfBandDecimateBy2::CHalfBandDecimateBy2(int len, const float * pCoef)
+    : m_FirLength(len)
+{
+    int         p;
 
-    tmpout[4] = H0 * d8 + H2 * pInData[0] + H4 * pInData[2] + H5 * pInData[3]
-            + H6 * pInData[4] + H8 * pInData[6] + H10 * pInData[8];
+    m_Pairs = (len + 1) / 4;
+    m_Center = pCoef[(len - 1) / 2];
+    m_Coef.resize(m_Pairs);
+    for (p = 0; p < m_Pairs; p++)
+        m_Coef[p] = pCoef[2 * p];
 
-    tmpout[5] = H0 * pInData[0] + H2 * pInData[2] + H4 * pInData[4]
-            + H5 * pInData[5] + H6 * pInData[6] + H8 * pInData[8]
-            + H10 * pInData[10];
+    // buffers grow if needed in DecBy2()
+    m_Even.resize(MIN_HALF_BAND_BUFSIZE, gr_complex(0.0, 0.0));
+    m_Odd.resize(MIN_HALF_BAND_BUFSIZE, gr_complex(0.0, 0.0));
 
-    tmpout[6] = H0 * pInData[2] + H2 * pInData[4] + H4 * pInData[6]
-            + H5 * pInData[7] + H6 * pInData[8] + H8 * pInData[10]
-            + H10 * pInData[12];
+    m_Kernel = hbf_select_kernel();
+}
 
-    tmpout[7] = H0 * pInData[4] + H2 * pInData[6] + H4 * pInData[8]
-            + H5 * pInData[9] + H6 * pInData[10] + H8 * pInData[12]
-            + H10 * pInData[14];
+/*
+ * Half band filter and decimate by 2 function.
+ * InLength must be an even number. pOutData may be the same as pInData.
+ */
+int Decimator::CHalfBandDecimateBy2::DecBy2(int InLength, const gr_complex * pInData,
+                                            gr_complex * pOutData)
+{
+    int     ehist = 2 * m_Pairs - 1;
+    int     ohist = m_Pairs;
+    int     nout = InLength / 2;
+    int     i;
 
-    tmpout[8] = H0 * pInData[6] + H2 * pInData[8] + H4 * pInData[10]
-            + H5 * pInData[11] + H6 * pInData[12] + H8 * pInData[14]
-            + H10 * pInData[16];
+    if ((int)m_Even.size() < nout + ehist)
+        m_Even.resize(nout + ehist);
+    if ((int)m_Odd.size() < nout + ohist)
+        m_Odd.resize(nout + ohist);
 
-    // now loop through remaining input samples
-    gr_complex     *pIn = &pInData[8];
-    gr_complex     *pOut = &pOutData[9];
-    int         i;
+    gr_complex *pEven = &m_Even[0];
+    gr_complex *pOdd = &m_Odd[0];
 
-    for(i = 0; i < (InLength - 11 - 6) / 2; i++)
+    // split input after the history
+    for (i = 0; i < nout; i++)
     {
-      *pOut++ = (H0 * pIn[0]) + (H2 * pIn[2]) + (H4 * pIn[4]) +
-        (H5 * pIn[5]) + (H6 * pIn[6]) + (H8 * pIn[8]) + (H10 * pIn[10]);
-      pIn += 2;
+        pEven[ehist + i] = pInData[2 * i];
+        pOdd[ohist + i] = pInData[2 * i + 1];
     }
 
-    // copy first outputs back into output array so outbuf can be same as inbuf
-    pOutData[0] = tmpout[0];
-    pOutData[1] = tmpout[1];
-    pOutData[2] = tmpout[2];
-    pOutData[3] = tmpout[3];
-    pOutData[4] = tmpout[4];
-    pOutData[5] = tmpout[5];
-    pOutData[6] = tmpout[6];
-    pOutData[7] = tmpout[7];
-    pOutData[8] = tmpout[8];
-
-    // copy last 10 input samples into delay buffer for next time
-    pIn = &pInData[InLength-1];
-    d9 = *pIn--;
-    d8 = *pIn--;
-    d7 = *pIn--;
-    d6 = *pIn--;
-    d5 = *pIn--;
-    d4 = *pIn--;
-    d3 = *pIn--;
-    d2 = *pIn--;
-    d1 = *pIn--;
-    d0 = *pIn;
-
-    return InLength / 2;
+    m_Kernel(pOutData, pEven, pOdd, nout, &m_Coef[0], m_Pairs, m_Center);
+
+    // keep history for next call
+    memmove(pEven, pEven + nout, ehist * sizeof(gr_complex));
+    memmove(pOdd, pOdd + nout, ohist * sizeof(gr_complex));
+
+    return nout;
 }
@@ -13,6 +13,7 @@
 #ifndef DECIMATOR_H
 #define DECIMATOR_H 1
 
+#include <vector>
 #include <gnuradio/gr_complex.h>
 
 #define MAX_DECIMATION          512
@@ -25,9 +26,18 @@ public:
     virtual    ~Decimator();
 
     unsigned int    init(unsigned int _decim, unsigned int _att);
-    int             process(int samples, gr_complex * pin,
+    int             process(int samples, const gr_complex * pin,
                             gr_complex * pout);
 
+    /**
+     * Signature of the half-band filter kernels. Computes
+     * out[n] = sum_p coef[p] * (even[n+p] + even[n+2*npairs-1-p]) + center * odd[n]
+     * for n = 0 .. nout-1.
+     */
+    typedef void (*HbfKernel)(gr_complex * out, const gr_complex * even,
+                              const gr_complex * odd, int nout,
+                              const float * coef, int npairs, float center);
+
 private:
 
     /**
@@ -38,44 +48,33 @@ private:
     public:
         CDec2() {}
         virtual    ~CDec2(){}
-        virtual int DecBy2(int InLength, gr_complex * pInData,
+        virtual int DecBy2(int InLength, const gr_complex * pInData,
                            gr_complex * pOutData) = 0;
     };
 
     /**
-     * Generic dcimate-by-2 class
+     * Generic decimate-by-2 class.
+     *
+     * The input is split into even and odd samples so that the filter only
+     * runs over the non-zero taps and the symmetric taps are folded, i.e.
+     * an L tap half-band filter needs (L+1)/4 + 1 multiplications per
+     * output. The kernel is selected at runtime (AVX2, NEON or scalar).
      */
     class CHalfBandDecimateBy2 : public CDec2
     {
     public:
         CHalfBandDecimateBy2(int len, const float * pCoef);
-        ~CHalfBandDecimateBy2() {
-            if(m_pHBFirBuf) delete [] m_pHBFirBuf;
-        }
-        int     DecBy2(int InLength, gr_complex * pInData,
+        ~CHalfBandDecimateBy2() {}
+        int     DecBy2(int InLength, const gr_complex * pInData,
                        gr_complex * pOutData);
 
-        gr_complex     *m_pHBFirBuf;
+        std::vector<gr_complex> m_Even;   // even samples incl. history
+        std::vector<gr_complex> m_Odd;    // odd samples incl. history
+        std::vector<float>      m_Coef;   // folded coefficients
+        float           m_Center;         // center coefficient
+        int             m_Pairs;          // number of folded coefficients
         int             m_FirLength;
-        const float    *m_pCoef;
-    };
-
-    /**
-     * 11-tap half-band filter with unrolled loop.
-     */
-    class CHalfBand11TapDecimateBy2 : public CDec2
-    {
-    public:
-        CHalfBand11TapDecimateBy2(const float * coef);
-        ~CHalfBand11TapDecimateBy2() {}
-        int     DecBy2(int InLength, gr_complex * pInData,
-                       gr_complex * pOutData);
-
-        // coefficients
-        float               H0, H2, H4, H5, H6, H8, H10;
-
-        // delay buffer
-        std::complex<float> d0, d1, d2, d3, d4, d5, d6, d7, d8, d9;
+        HbfKernel       m_Kernel;
     };
 
 private:
@@ -85,6 +84,9 @@ private:
     void        delete_filters();
     CDec2      *filter_table[MAX_STAGES];
 
+    // work buffer so that the input is never modified
+    std::vector<gr_complex> buf;
+
     unsigned int        atten;
     unsigned int        decim;
 };
@@ -24,13 +24,17 @@
 #include <gnuradio/gr_complex.h>
 #include <gnuradio/io_signature.h>
 #include <gnuradio/types.h>
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <stdio.h>
 
 #include "filter/decimator.h"
 #include "hbf_decim.h"
 
 
+#define HBF_MAX_CHUNK 32768u
+
 hbf_decim_sptr make_hbf_decim(unsigned int decim)
 {
     return gnuradio::get_initial_sptr (new hbf_decim(decim));
@@ -46,7 +50,16 @@ hbf_decim::hbf_decim(unsigned int decim)
     if (dec->init(decim, 100) != decim)
         throw std::range_error("Decimation not supported");
 
+    /* HBF input length must be even and >= number of taps.
+     * Max taps is 87 => we need at least 44 * decim input samples.
+     * Also limit the chunk size so that the internal buffers stay small.
+     */
+    set_min_noutput_items(44);
+    set_max_noutput_items(std::max(44u, HBF_MAX_CHUNK / decim));
+
+#ifndef QT_NO_DEBUG_OUTPUT
     std::cout << "New decimator: " << decimation << std::endl;
+#endif
 }
 
 hbf_decim::~hbf_decim()
@@ -58,12 +71,9 @@ int hbf_decim::work(int noutput_items,
           gr_vector_const_void_star &input_items,
           gr_vector_void_star &output_items)
 {
-    gr_complex *in = (gr_complex *) input_items[0];
+    const gr_complex *in = (const gr_complex *) input_items[0];
     gr_complex *out = (gr_complex *) output_items[0];
 
-    /* HBF input length must be even and >= number of taps.
-     * Max taps is 87 => we need at least 44 * decim input samples
-     */
     if (noutput_items < 44)
         return 0;
 
@@ -45,6 +45,8 @@ public:
              gr_vector_const_void_star &input_items,
              gr_vector_void_star &output_items);
 
+    unsigned int get_decim() const { return decimation; }
+
 private:
     Decimator          *dec;
     unsigned int        decimation;
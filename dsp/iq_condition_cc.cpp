@@ -0,0 +1,191 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <gnuradio/io_signature.h>
+#include <volk/volk.h>
+#include "dsp/iq_condition_cc.h"
+
+/* Chunk size. Small enough for the chunk to stay in L1 while the
+ * statistics and the corrections are applied.
+ */
+#define IQ_COND_CHUNK 512
+
+
+iq_condition_cc_sptr make_iq_condition_cc(double sample_rate, double tau)
+{
+    return gnuradio::get_initial_sptr(new iq_condition_cc(sample_rate, tau));
+}
+
+
+/*! \brief Create I/Q conditioning block.
+ *
+ * Use make_iq_condition_cc() instead.
+ */
+iq_condition_cc::iq_condition_cc(double sample_rate, double tau)
+    : gr::sync_block ("iq_condition_cc",
+          gr::io_signature::make(1, 1, sizeof(gr_complex)),
+          gr::io_signature::make(1, 1, sizeof(gr_complex))),
+      d_swap(false),
+      d_dc_cancel(false),
+      d_iq_balance(false),
+      d_sample_rate(sample_rate),
+      d_tau(tau),
+      d_cur_sample_rate(0.0),
+      d_cur_tau(0.0),
+      d_alpha(1.0),
+      d_dc(0.0f, 0.0f),
+      d_ii(0.0),
+      d_qq(0.0),
+      d_iq(0.0),
+      d_ones(IQ_COND_CHUNK, 1.0f)
+{
+}
+
+iq_condition_cc::~iq_condition_cc()
+{
+
+}
+
+int iq_condition_cc::work(int noutput_items,
+                          gr_vector_const_void_star &input_items,
+                          gr_vector_void_star &output_items)
+{
+    const gr_complex *in = (const gr_complex *) input_items[0];
+    gr_complex *out = (gr_complex *) output_items[0];
+
+    double sample_rate = d_sample_rate.load();
+    double tau = d_tau.load();
+    if (sample_rate != d_cur_sample_rate || tau != d_cur_tau)
+    {
+        d_cur_sample_rate = sample_rate;
+        d_cur_tau = tau;
+        d_alpha = 1.0 / (1.0 + tau * sample_rate);
+
+#ifndef QT_NO_DEBUG_OUTPUT
+        std::cout << "IQ COND samp_rate: " << sample_rate << std::endl;
+        std::cout << "IQ COND alpha: " << d_alpha << std::endl;
+#endif
+    }
+
+    bool swap = d_swap.load();
+    bool dc_cancel = d_dc_cancel.load();
+    bool iq_balance = d_iq_balance.load();
+
+    if (!dc_cancel)
+        d_dc = gr_complex(0.0f, 0.0f);
+    if (!iq_balance)
+        d_ii = d_qq = d_iq = 0.0;
+
+    for (int i = 0; i < noutput_items; i += IQ_COND_CHUNK)
+    {
+        int n = std::min(noutput_items - i, IQ_COND_CHUNK);
+        process_chunk(out + i, in + i, n, swap, dc_cancel, iq_balance);
+    }
+
+    return noutput_items;
+}
+
+/*! \brief Condition one chunk of at most IQ_COND_CHUNK samples. */
+void iq_condition_cc::process_chunk(gr_complex *out, const gr_complex *in, int n,
+                                    bool swap, bool dc_cancel, bool iq_balance)
+{
+    int i;
+
+    if (swap)
+    {
+        for (i = 0; i < n; i++)
+            out[i] = gr_complex(in[i].imag(), in[i].real());
+    }
+    else if (out != in)
+    {
+        memcpy(out, in, n * sizeof(gr_complex));
+    }
+
+    if (!dc_cancel && !iq_balance)
+        return;
+
+    /* response of the single pole IIR to n samples of constant input */
+    float beta = (float)(1.0 - pow(1.0 - d_alpha, n));
+
+    if (dc_cancel)
+    {
+        gr_complex sum;
+
+        volk_32fc_32f_dot_prod_32fc(&sum, out, &d_ones[0], n);
+        d_dc += beta * (sum / (float)n - d_dc);
+
+        float *f = (float *) out;
+        float dc_re = d_dc.real();
+        float dc_im = d_dc.imag();
+        for (i = 0; i < 2 * n; i += 2)
+        {
+            f[i] -= dc_re;
+            f[i + 1] -= dc_im;
+        }
+    }
+
+    if (iq_balance)
+    {
+        gr_complex pwr;     // sum(|x|^2) = sum(I*I + Q*Q)
+        gr_complex sqr;     // sum(x^2) = sum(I*I - Q*Q) + 2j*sum(I*Q)
+
+        volk_32fc_x2_conjugate_dot_prod_32fc(&pwr, out, out, n);
+        volk_32fc_x2_dot_prod_32fc(&sqr, out, out, n);
+
+        double ii = 0.5 * (pwr.real() + sqr.real()) / n;
+        double qq = 0.5 * (pwr.real() - sqr.real()) / n;
+        double iq = 0.5 * sqr.imag() / n;
+
+        if (d_ii <= 0.0)
+        {
+            d_ii = ii;
+            d_qq = qq;
+            d_iq = iq;
+        }
+        else
+        {
+            d_ii += beta * (ii - d_ii);
+            d_qq += beta * (qq - d_qq);
+            d_iq += beta * (iq - d_iq);
+        }
+
+        if (d_ii <= 0.0)
+            return;
+
+        // Q - p*I is uncorrelated with I; g scales it to the power of I
+        double p = d_iq / d_ii;
+        double q_pwr = d_qq - p * d_iq;
+        if (q_pwr <= 0.0)
+            return;
+
+        float g = (float) sqrt(d_ii / q_pwr);
+        float gp = (float)(g * p);
+
+        float *f = (float *) out;
+        for (i = 0; i < 2 * n; i += 2)
+            f[i + 1] = g * f[i + 1] - gp * f[i];
+    }
+}
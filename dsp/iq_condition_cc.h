@@ -0,0 +1,109 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef IQ_CONDITION_CC_H
+#define IQ_CONDITION_CC_H
+
+#include <vector>
+#include <boost/atomic.hpp>
+#include <gnuradio/sync_block.h>
+
+
+class iq_condition_cc;
+
+typedef boost::shared_ptr<iq_condition_cc> iq_condition_cc_sptr;
+
+
+/*! \brief Return a shared_ptr to a new instance of iq_condition_cc.
+ *  \param sample_rate The sample rate.
+ *  \param tau The time constant of the DC and I/Q balance estimators in seconds.
+ *
+ * This is effectively the public constructor. To avoid accidental use
+ * of raw pointers, the iq_condition_cc constructor is private.
+ * make_iq_condition_cc is the public interface for creating new instances.
+ */
+iq_condition_cc_sptr make_iq_condition_cc(double sample_rate, double tau=1.0);
+
+
+/*! \brief I/Q swap, DC removal and I/Q balance in one block.
+ *  \ingroup DSP
+ *
+ * Replaces the previous iq_swap_cc and dc_corr_cc hier blocks, which needed
+ * four GNU Radio blocks and their buffers at the full input rate.
+ *
+ * The input is processed in chunks of 512 samples. For each chunk:
+ *  - I and Q are optionally swapped while copying to the output.
+ *  - The DC estimate is updated with the chunk mean and subtracted. The
+ *    update is the exact single pole IIR response to a constant input, so
+ *    the time constant is the same as for the per-sample filter.
+ *  - The I/Q imbalance is estimated blindly from E[I*I], E[Q*Q] and E[I*Q]
+ *    and corrected as Q' = g * (Q - p * I), where p removes the
+ *    correlation between I and Q (phase error) and g equalizes the powers
+ *    (gain error).
+ *
+ * All steps are vector operations using VOLK or simple loops over a chunk
+ * that stays in the L1 cache. All settings can be changed from any thread
+ * while the flow graph is running.
+ */
+class iq_condition_cc : public gr::sync_block
+{
+    friend iq_condition_cc_sptr make_iq_condition_cc(double sample_rate, double tau);
+
+protected:
+    iq_condition_cc(double sample_rate, double tau);
+
+public:
+    ~iq_condition_cc();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+    void set_swap(bool enabled) { d_swap.store(enabled); }
+    void set_dc_cancel(bool enabled) { d_dc_cancel.store(enabled); }
+    void set_iq_balance(bool enabled) { d_iq_balance.store(enabled); }
+    void set_sample_rate(double sample_rate) { d_sample_rate.store(sample_rate); }
+    void set_tau(double tau) { d_tau.store(tau); }
+
+private:
+    boost::atomic<bool>   d_swap;         /*! Swap I and Q. */
+    boost::atomic<bool>   d_dc_cancel;    /*! Remove DC. */
+    boost::atomic<bool>   d_iq_balance;   /*! Correct I/Q imbalance. */
+    boost::atomic<double> d_sample_rate;  /*! Requested sample rate. */
+    boost::atomic<double> d_tau;          /*! Requested time constant. */
+
+    /* work() side */
+    double      d_cur_sample_rate;  /*! Sample rate used for d_alpha. */
+    double      d_cur_tau;          /*! Time constant used for d_alpha. */
+    double      d_alpha;            /*! Per-sample IIR coefficient. */
+    gr_complex  d_dc;               /*! DC estimate. */
+    double      d_ii;               /*! Estimate of E[I*I]. */
+    double      d_qq;               /*! Estimate of E[Q*Q]. */
+    double      d_iq;               /*! Estimate of E[I*Q]. */
+    std::vector<float> d_ones;      /*! Vector of ones for the chunk mean. */
+
+    void process_chunk(gr_complex *out, const gr_complex *in, int n,
+                       bool swap, bool dc_cancel, bool iq_balance);
+};
+
+
+#endif /* IQ_CONDITION_CC_H */
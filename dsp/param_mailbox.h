@@ -0,0 +1,159 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef PARAM_MAILBOX_H
+#define PARAM_MAILBOX_H
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include "dsp/triple_buffer.h"
+
+
+/*! \brief Global counters shared by all parameter mailboxes.
+ *  \ingroup DSP
+ *
+ * Intended for profiling. The counters only ever increase.
+ */
+class param_mailbox_stats
+{
+public:
+    /*! \brief Number of parameter sets published by the GUI side. */
+    static unsigned long updates() { return s_updates.load(boost::memory_order_relaxed); }
+
+    /*! \brief Number of parameter sets replaced before work() picked them up. */
+    static unsigned long overwritten() { return s_overwritten.load(boost::memory_order_relaxed); }
+
+    /*! \brief Number of times a setter had to wait for another setter. */
+    static unsigned long contention() { return s_contention.load(boost::memory_order_relaxed); }
+
+protected:
+    static boost::atomic<unsigned long> s_updates;
+    static boost::atomic<unsigned long> s_overwritten;
+    static boost::atomic<unsigned long> s_contention;
+};
+
+
+/*! \brief Lock-free hand over of a parameter struct to a work() method.
+ *  \ingroup DSP
+ *
+ * The setters of a block modify a copy of the parameter struct T through
+ * a scoped_update, which publishes a complete snapshot when it goes out of
+ * scope. work() calls fetch() once per call and, if it returns true,
+ * applies params(). work() never waits; setters are serialized among
+ * themselves by a mutex that work() does not touch.
+ *
+ * Example:
+ * \code
+ *   void my_block::set_gain(float gain)
+ *   {
+ *       param_mailbox<my_params>::scoped_update p(d_params);
+ *       p->gain = gain;
+ *   }
+ *
+ *   int my_block::work(...)
+ *   {
+ *       if (d_params.fetch())
+ *           apply(d_params.params());
+ *       ...
+ *   }
+ * \endcode
+ */
+template <class T>
+class param_mailbox : public param_mailbox_stats
+{
+public:
+    /*! \brief Create a new mailbox.
+     *  \param init The initial parameters, seen by fetch() as new.
+     */
+    explicit param_mailbox(const T &init = T())
+        : d_buf(init),
+          d_current(init)
+    {
+        d_buf.publish();
+    }
+
+    /*! \brief Modify and publish the parameters (setter side). */
+    class scoped_update
+    {
+    public:
+        explicit scoped_update(param_mailbox &mb)
+            : d_mb(mb)
+        {
+            if (!d_mb.d_mutex.try_lock())
+            {
+                s_contention.fetch_add(1, boost::memory_order_relaxed);
+                d_mb.d_mutex.lock();
+            }
+        }
+
+        ~scoped_update()
+        {
+            d_mb.d_buf.write_buffer() = d_mb.d_current;
+            if (d_mb.d_buf.publish())
+                s_overwritten.fetch_add(1, boost::memory_order_relaxed);
+            s_updates.fetch_add(1, boost::memory_order_relaxed);
+            d_mb.d_mutex.unlock();
+        }
+
+        T *operator->() { return &d_mb.d_current; }
+        T &operator*() { return d_mb.d_current; }
+
+    private:
+        param_mailbox &d_mb;
+
+        scoped_update(const scoped_update &);
+        scoped_update &operator=(const scoped_update &);
+    };
+    friend class scoped_update;
+
+    /*! \brief Get a copy of the latest parameters (setter side). */
+    T get()
+    {
+        boost::mutex::scoped_lock lock(d_mutex);
+        return d_current;
+    }
+
+    /*! \brief Pick up new parameters (work() side).
+     *  \returns true if params() has changed since the previous call.
+     */
+    bool fetch()
+    {
+        return d_buf.fetch();
+    }
+
+    /*! \brief The parameters last picked up by fetch() (work() side). */
+    const T &params()
+    {
+        return d_buf.read_buffer();
+    }
+
+private:
+    triple_buffer<T> d_buf;      /*! Snapshots passed to work(). */
+    T                d_current;  /*! Latest parameters, guarded by d_mutex. */
+    boost::mutex     d_mutex;    /*! Serializes the setters. */
+
+    /* not copyable */
+    param_mailbox(const param_mailbox &);
+    param_mailbox &operator=(const param_mailbox &);
+};
+
+#endif /* PARAM_MAILBOX_H */
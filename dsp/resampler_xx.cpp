@@ -20,24 +20,24 @@
  * the Free Software Foundation, Inc., 51 Franklin Street,
  * Boston, MA 02110-1301, USA.
  */
-#include <cstdio>
+#include <math.h>
 #include <gnuradio/io_signature.h>
 #include <gnuradio/filter/firdes.h>
+#include <volk/volk.h>
 #include "dsp/resampler_xx.h"
 
 
-/* Create a new instance of resampler_cc and return
- * a boost shared_ptr. This is effectively the public constructor.
- */
-resampler_cc_sptr make_resampler_cc(float rate)
-{
-    return gnuradio::get_initial_sptr(new resampler_cc(rate));
-}
+/*! \brief Number of polyphase branches. */
+#define RESAMPLER_NFILTS 32
 
-resampler_cc::resampler_cc(float rate)
-    : gr::hier_block2 ("resampler_cc",
-          gr::io_signature::make (1, 1, sizeof(gr_complex)),
-          gr::io_signature::make (1, 1, sizeof(gr_complex)))
+
+/*! \brief Design the filter bank for a new rate.
+ *  \param new_rate Resampling rate, i.e. output/input.
+ *
+ * The existing vectors are reused so that repeated designs for filter
+ * banks of the same size do not allocate.
+ */
+void resampler_taps::design(float new_rate)
 {
     /* I ceated this code based on:
        http://gnuradio.squarespace.com/blog/2010/12/6/new-interface-for-pfb_arb_resampler_ccf.html
@@ -47,20 +47,128 @@ resampler_cc::resampler_cc(float rate)
        Note: In case of decimation, we limit the cutoff to the output bandwidth to avoid "phantom"
              signals when we have a frequency translation in front of the PFB resampler.
     */
+    double cutoff = new_rate > 1.0 ? 0.4 : 0.4*new_rate;
+    double trans_width = new_rate > 1.0 ? 0.2 : 0.2*new_rate;
+    std::vector<float> proto = gr::filter::firdes::low_pass(RESAMPLER_NFILTS, RESAMPLER_NFILTS,
+                                                            cutoff, trans_width);
+    unsigned int i, j, k;
+
+    rate = new_rate;
+    nfilts = RESAMPLER_NFILTS;
+    ntaps = (proto.size() + nfilts - 1) / nfilts;
+    dec_rate = (unsigned int) floor(nfilts / rate);
+    flt_rate = nfilts / rate - dec_rate;
+
+    /* the last difference tap of the prototype is 0 */
+    proto.resize(nfilts * ntaps + 1, 0.0f);
+
+    taps.resize(nfilts * ntaps);
+    dtaps.resize(nfilts * ntaps);
+    for (i = 0; i < nfilts; i++)
+    {
+        for (j = 0; j < ntaps; j++)
+        {
+            k = i + j * nfilts;
+            taps[i * ntaps + ntaps - 1 - j] = proto[k];
+            dtaps[i * ntaps + ntaps - 1 - j] = proto[k + 1] - proto[k];
+        }
+    }
+}
 
-    /* generate taps */
-    double cutoff = rate > 1.0 ? 0.4 : 0.4*rate;
-    double trans_width = rate > 1.0 ? 0.2 : 0.2*rate;
-    unsigned int flt_size = 32;
+/*! \brief Get a new filter bank for the given rate. */
+static resampler_taps design_taps(float rate)
+{
+    resampler_taps t;
+
+    t.design(rate);
 
-    d_taps = gr::filter::firdes::low_pass(flt_size, flt_size, cutoff, trans_width);
+    return t;
+}
 
-    /* create the filter */
-    d_filter = gr::filter::pfb_arb_resampler_ccf::make(rate, d_taps, flt_size);
+static inline void dot_prod(gr_complex *result, const gr_complex *in, const float *taps,
+                            unsigned int n)
+{
+    volk_32fc_32f_dot_prod_32fc(result, in, taps, n);
+}
+
+static inline void dot_prod(float *result, const float *in, const float *taps,
+                            unsigned int n)
+{
+    volk_32f_x2_dot_prod_32f(result, in, taps, n);
+}
+
+/*! \brief Resample a block of samples.
+ *  \param t The filter bank.
+ *  \param acc The fractional branch accumulator.
+ *  \param j The next branch to use (may be >= nfilts when input ran out).
+ *  \param in The input samples.
+ *  \param ninput Number of input samples.
+ *  \param out The output buffer.
+ *  \param noutput Size of the output buffer.
+ *  \param nconsumed Number of input samples that can be consumed.
+ *  \return The number of output samples.
+ *
+ * The last ntaps-1 input samples are never consumed so they remain
+ * available as history for the next call.
+ */
+template <class T>
+static int resample(const resampler_taps &t, float &acc, unsigned int &j,
+                    const T *in, int ninput, T *out, int noutput, int *nconsumed)
+{
+    int avail = ninput - (int) t.ntaps + 1;
+    int i_in = 0;
+    int i_out = 0;
+    int adv;
+    T   o0, o1;
+
+    while (i_out < noutput)
+    {
+        adv = j / t.nfilts;
+        if (i_in + adv >= avail)
+            break;
+
+        i_in += adv;
+        j -= adv * t.nfilts;
+
+        dot_prod(&o0, &in[i_in], &t.taps[j * t.ntaps], t.ntaps);
+        dot_prod(&o1, &in[i_in], &t.dtaps[j * t.ntaps], t.ntaps);
+        out[i_out++] = o0 + o1 * acc;
+
+        acc += t.flt_rate;
+        adv = (int) acc;
+        j += t.dec_rate + adv;
+        acc -= adv;
+    }
+
+    *nconsumed = i_in;
+
+    return i_out;
+}
+
+/*! \brief Number of input samples needed for noutput output samples. */
+static int resampler_forecast(const resampler_taps &t, unsigned int j, int noutput)
+{
+    return (int) ceil(noutput / t.rate) + t.ntaps + j / t.nfilts;
+}
+
+
+/* Create a new instance of resampler_cc and return
+ * a boost shared_ptr. This is effectively the public constructor.
+ */
+resampler_cc_sptr make_resampler_cc(float rate)
+{
+    return gnuradio::get_initial_sptr(new resampler_cc(rate));
+}
 
-    /* connect filter */
-    connect(self(), 0, d_filter, 0);
-    connect(d_filter, 0, self(), 0);
+resampler_cc::resampler_cc(float rate)
+    : gr::block ("resampler_cc",
+          gr::io_signature::make (1, 1, sizeof(gr_complex)),
+          gr::io_signature::make (1, 1, sizeof(gr_complex))),
+      d_taps(design_taps(rate)),
+      d_acc(0.0f),
+      d_last_filter(0)
+{
+    set_relative_rate(rate);
 }
 
 resampler_cc::~resampler_cc()
@@ -68,25 +176,43 @@ resampler_cc::~resampler_cc()
 
 }
 
+/*! \brief Set new resampling rate.
+ *  \param rate Resampling rate, i.e. output/input.
+ *
+ * The new filter bank is used from the next call to general_work().
+ */
 void resampler_cc::set_rate(float rate)
 {
-    /* generate taps */
-    double cutoff = rate > 1.0 ? 0.4 : 0.4*rate;
-    double trans_width = rate > 1.0 ? 0.2 : 0.2*rate;
-    unsigned int flt_size = 32;
-    d_taps = gr::filter::firdes::low_pass(flt_size, flt_size, cutoff, trans_width);
+    d_taps.write_buffer().design(rate);
+    d_taps.publish();
+    set_relative_rate(rate);
+}
+
+void resampler_cc::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+{
+    ninput_items_required[0] = resampler_forecast(d_taps.read_buffer(), d_last_filter,
+                                                  noutput_items);
+}
+
+int resampler_cc::general_work(int noutput_items,
+                               gr_vector_int &ninput_items,
+                               gr_vector_const_void_star &input_items,
+                               gr_vector_void_star &output_items)
+{
+    const gr_complex *in = (const gr_complex *) input_items[0];
+    gr_complex *out = (gr_complex *) output_items[0];
+    int nconsumed;
+    int nproduced;
+
+    d_taps.fetch();
+    nproduced = resample(d_taps.read_buffer(), d_acc, d_last_filter,
+                         in, ninput_items[0], out, noutput_items, &nconsumed);
+    consume_each(nconsumed);
 
-    /* FIXME: Should implement set_taps() in PFB */
-    lock();
-    disconnect(self(), 0, d_filter, 0);
-    disconnect(d_filter, 0, self(), 0);
-    d_filter.reset();
-    d_filter = gr::filter::pfb_arb_resampler_ccf::make(rate, d_taps, flt_size);
-    connect(self(), 0, d_filter, 0);
-    connect(d_filter, 0, self(), 0);
-    unlock();
+    return nproduced;
 }
 
+
 /* Create a new instance of resampler_ff and return
  * a boost shared_ptr. This is effectively the public constructor.
  */
@@ -96,32 +222,14 @@ resampler_ff_sptr make_resampler_ff(float rate)
 }
 
 resampler_ff::resampler_ff(float rate)
-    : gr::hier_block2 ("resampler_ff",
+    : gr::block ("resampler_ff",
           gr::io_signature::make (1, 1, sizeof(float)),
-          gr::io_signature::make (1, 1, sizeof(float)))
+          gr::io_signature::make (1, 1, sizeof(float))),
+      d_taps(design_taps(rate)),
+      d_acc(0.0f),
+      d_last_filter(0)
 {
-    /* I ceated this code based on:
-       http://gnuradio.squarespace.com/blog/2010/12/6/new-interface-for-pfb_arb_resampler_ccf.html
-
-       and blks2.pfb_arb_resampler.py
-
-       Note: In case of decimation, we limit the cutoff to the output bandwidth to avoid "phantom"
-             signals when we have a frequency translation in front of the PFB resampler.
-    */
-
-    /* generate taps */
-    double cutoff = rate > 1.0 ? 0.4 : 0.4*rate;
-    double trans_width = rate > 1.0 ? 0.2 : 0.2*rate;
-    unsigned int flt_size = 32;
-
-    d_taps = gr::filter::firdes::low_pass(flt_size, flt_size, cutoff, trans_width);
-
-    /* create the filter */
-    d_filter = gr::filter::pfb_arb_resampler_fff::make(rate, d_taps, flt_size);
-
-    /* connect filter */
-    connect(self(), 0, d_filter, 0);
-    connect(d_filter, 0, self(), 0);
+    set_relative_rate(rate);
 }
 
 resampler_ff::~resampler_ff()
@@ -129,21 +237,38 @@ resampler_ff::~resampler_ff()
 
 }
 
+/*! \brief Set new resampling rate.
+ *  \param rate Resampling rate, i.e. output/input.
+ *
+ * The new filter bank is used from the next call to general_work().
+ */
 void resampler_ff::set_rate(float rate)
 {
-    /* generate taps */
-    double cutoff = rate > 1.0 ? 0.4 : 0.4*rate;
-    double trans_width = rate > 1.0 ? 0.2 : 0.2*rate;
-    unsigned int flt_size = 32;
-    d_taps = gr::filter::firdes::low_pass(flt_size, flt_size, cutoff, trans_width);
-
-    /* FIXME: Should implement set_taps() in PFB */
-    lock();
-    disconnect(self(), 0, d_filter, 0);
-    disconnect(d_filter, 0, self(), 0);
-    d_filter.reset();
-    d_filter = gr::filter::pfb_arb_resampler_fff::make(rate, d_taps, flt_size);
-    connect(self(), 0, d_filter, 0);
-    connect(d_filter, 0, self(), 0);
-    unlock();
+    d_taps.write_buffer().design(rate);
+    d_taps.publish();
+    set_relative_rate(rate);
+}
+
+void resampler_ff::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+{
+    ninput_items_required[0] = resampler_forecast(d_taps.read_buffer(), d_last_filter,
+                                                  noutput_items);
+}
+
+int resampler_ff::general_work(int noutput_items,
+                               gr_vector_int &ninput_items,
+                               gr_vector_const_void_star &input_items,
+                               gr_vector_void_star &output_items)
+{
+    const float *in = (const float *) input_items[0];
+    float *out = (float *) output_items[0];
+    int nconsumed;
+    int nproduced;
+
+    d_taps.fetch();
+    nproduced = resample(d_taps.read_buffer(), d_acc, d_last_filter,
+                         in, ninput_items[0], out, noutput_items, &nconsumed);
+    consume_each(nconsumed);
+
+    return nproduced;
 }
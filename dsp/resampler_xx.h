@@ -23,9 +23,9 @@
 #ifndef RESAMPLER_XX_H
 #define RESAMPLER_XX_H
 
-#include <gnuradio/hier_block2.h>
-#include <gnuradio/filter/pfb_arb_resampler_ccf.h>
-#include <gnuradio/filter/pfb_arb_resampler_fff.h>
+#include <vector>
+#include <gnuradio/block.h>
+#include "dsp/triple_buffer.h"
 
 
 class resampler_cc;
@@ -35,6 +35,30 @@ typedef boost::shared_ptr<resampler_cc> resampler_cc_sptr;
 typedef boost::shared_ptr<resampler_ff> resampler_ff_sptr;
 
 
+/*! \brief Filter bank used by the arbitrary rate resamplers.
+ *  \ingroup DSP
+ *
+ * The prototype low pass filter is split into nfilts polyphase branches
+ * of ntaps taps each. Each branch is stored time reversed so that it can
+ * be applied with a plain dot product, followed by the difference to the
+ * next branch used for linear interpolation between branches.
+ */
+struct resampler_taps
+{
+    resampler_taps() : rate(1.0), nfilts(0), ntaps(0), dec_rate(0), flt_rate(0.0f) {}
+
+    void design(float new_rate);
+
+    float              rate;      /*!< Resampling rate, i.e. output/input. */
+    unsigned int       nfilts;    /*!< Number of polyphase branches. */
+    unsigned int       ntaps;     /*!< Number of taps per branch. */
+    unsigned int       dec_rate;  /*!< Integer part of nfilts/rate. */
+    float              flt_rate;  /*!< Fractional part of nfilts/rate. */
+    std::vector<float> taps;      /*!< Branch taps, nfilts x ntaps. */
+    std::vector<float> dtaps;     /*!< Branch difference taps, nfilts x ntaps. */
+};
+
+
 /*! \brief Return a shared_ptr to a new instance of resampler_cc.
  *  \param rate Resampling rate, i.e. output/input.
  *
@@ -42,25 +66,43 @@ typedef boost::shared_ptr<resampler_ff> resampler_ff_sptr;
  */
 resampler_cc_sptr make_resampler_cc(float rate);
 
-/*! \brief Arbitrary rate resampler based on gr_pfb_arb_resampler_ccf
+/*! \brief Arbitrary rate resampler (complex input and output).
  *  \ingroup DSP
  *
- * This block is a convenience wrapper around gr_pfb_arb_resampler_ccf. It takes care
- * of generating filter taps that can be used for the filter, as well as calculating
- * the other required parameters.
+ * Polyphase arbitrary rate resampler using the same algorithm as
+ * gr::filter::pfb_arb_resampler_ccf. It also generates the filter taps
+ * for the requested rate.
+ *
+ * Unlike the GNU Radio block the rate can be changed while the flow graph
+ * is running without locking it. set_rate() designs the new filter bank
+ * in the calling thread and hands it over to work() through a triple
+ * buffer, so the switch is allocation-free on the DSP thread and the
+ * filter history and phase are preserved. set_rate() must only be called
+ * from one thread at a time.
  */
-class resampler_cc : public gr::hier_block2
+class resampler_cc : public gr::block
 {
+    friend resampler_cc_sptr make_resampler_cc(float rate);
+
+protected:
+    resampler_cc(float rate);
 
 public:
-    resampler_cc(float rate); // FIXME: should be private
     ~resampler_cc();
 
+    void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+    int general_work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+
     void set_rate(float rate);
 
 private:
-    std::vector<float>            d_taps;
-    gr::filter::pfb_arb_resampler_ccf::sptr d_filter;
+    triple_buffer<resampler_taps> d_taps;  /*! Filter bank, written by set_rate(). */
+    float        d_acc;          /*! Fractional branch accumulator. */
+    unsigned int d_last_filter;  /*! Next branch to use. */
 };
 
 
@@ -72,25 +114,34 @@ private:
 resampler_ff_sptr make_resampler_ff(float rate);
 
 
-/*! \brief Arbitrary rate resampler based on gr_pfb_arb_resampler_fff
+/*! \brief Arbitrary rate resampler (real input and output).
  *  \ingroup DSP
  *
- * This block is a convenience wrapper around gr_pfb_arb_resampler_fff. It takes care
- * of generating filter taps that can be used for the filter, as well as calculating
- * the other required parameters.
+ * Real version of resampler_cc.
  */
-class resampler_ff : public gr::hier_block2
+class resampler_ff : public gr::block
 {
+    friend resampler_ff_sptr make_resampler_ff(float rate);
+
+protected:
+    resampler_ff(float rate);
 
 public:
-    resampler_ff(float rate); // FIXME: should be private
     ~resampler_ff();
 
+    void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+    int general_work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+
     void set_rate(float rate);
 
 private:
-    std::vector<float>            d_taps;
-    gr::filter::pfb_arb_resampler_fff::sptr d_filter;
+    triple_buffer<resampler_taps> d_taps;  /*! Filter bank, written by set_rate(). */
+    float        d_acc;          /*! Fractional branch accumulator. */
+    unsigned int d_last_filter;  /*! Next branch to use. */
 };
 
 #endif // RESAMPLER_XX_H
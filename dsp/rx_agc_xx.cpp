@@ -33,6 +33,22 @@ rx_agc_cc_sptr make_rx_agc_cc(double sample_rate, bool agc_on, int threshold,
                                                     use_hang));
 }
 
+static rx_agc_params agc_params(double sample_rate, bool agc_on, int threshold,
+                                int manual_gain, int slope, int decay, bool use_hang)
+{
+    rx_agc_params p;
+
+    p.agc_on = agc_on;
+    p.sample_rate = sample_rate;
+    p.threshold = threshold;
+    p.manual_gain = manual_gain;
+    p.slope = slope;
+    p.decay = decay;
+    p.use_hang = use_hang;
+
+    return p;
+}
+
 /**
  * \brief Create receiver AGC object.
  *
@@ -43,17 +59,10 @@ rx_agc_cc::rx_agc_cc(double sample_rate, bool agc_on, int threshold,
     : gr::sync_block ("rx_agc_cc",
           gr::io_signature::make(1, 1, sizeof(gr_complex)),
           gr::io_signature::make(1, 1, sizeof(gr_complex))),
-      d_agc_on(agc_on),
-      d_sample_rate(sample_rate),
-      d_threshold(threshold),
-      d_manual_gain(manual_gain),
-      d_slope(slope),
-      d_decay(decay),
-      d_use_hang(use_hang)
+      d_params(agc_params(sample_rate, agc_on, threshold, manual_gain,
+                          slope, decay, use_hang))
 {
     d_agc = new CAgc();
-    d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                         d_slope, d_decay, d_sample_rate);
 }
 
 rx_agc_cc::~rx_agc_cc()
@@ -74,7 +83,13 @@ int rx_agc_cc::work(int noutput_items,
     const gr_complex *in = (const gr_complex *) input_items[0];
     gr_complex *out = (gr_complex *) output_items[0];
 
-    boost::mutex::scoped_lock lock(d_mutex);
+    if (d_params.fetch())
+    {
+        const rx_agc_params &p = d_params.params();
+        d_agc->SetParameters(p.agc_on, p.use_hang, p.threshold, p.manual_gain,
+                             p.slope, p.decay, p.sample_rate);
+    }
+
     d_agc->ProcessData(noutput_items, in, out);
 
     return noutput_items;
@@ -90,12 +105,8 @@ int rx_agc_cc::work(int noutput_items,
  */
 void rx_agc_cc::set_agc_on(bool agc_on)
 {
-    if (agc_on != d_agc_on) {
-        boost::mutex::scoped_lock lock(d_mutex);
-        d_agc_on = agc_on;
-        d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                             d_slope, d_decay, d_sample_rate);
-    }
+    param_mailbox<rx_agc_params>::scoped_update p(d_params);
+    p->agc_on = agc_on;
 }
 
 /**
@@ -107,12 +118,8 @@ void rx_agc_cc::set_agc_on(bool agc_on)
  */
 void rx_agc_cc::set_sample_rate(double sample_rate)
 {
-    if (sample_rate != d_sample_rate) {
-        boost::mutex::scoped_lock lock(d_mutex);
-        d_sample_rate = sample_rate;
-        d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                             d_slope, d_decay, d_sample_rate);
-    }
+    param_mailbox<rx_agc_params>::scoped_update p(d_params);
+    p->sample_rate = sample_rate;
 }
 
 /**
@@ -123,11 +130,9 @@ void rx_agc_cc::set_sample_rate(double sample_rate)
  */
 void rx_agc_cc::set_threshold(int threshold)
 {
-    if ((threshold != d_threshold) && (threshold >= -160) && (threshold <= 0)) {
-        boost::mutex::scoped_lock lock(d_mutex);
-        d_threshold = threshold;
-        d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                             d_slope, d_decay, d_sample_rate);
+    if ((threshold >= -160) && (threshold <= 0)) {
+        param_mailbox<rx_agc_params>::scoped_update p(d_params);
+        p->threshold = threshold;
     }
 }
 
@@ -141,11 +146,9 @@ void rx_agc_cc::set_threshold(int threshold)
  */
 void rx_agc_cc::set_manual_gain(int gain)
 {
-    if ((gain != d_manual_gain) && (gain >= 0) && (gain <= 100)) {
-        boost::mutex::scoped_lock lock(d_mutex);
-        d_manual_gain = gain;
-        d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                             d_slope, d_decay, d_sample_rate);
+    if ((gain >= 0) && (gain <= 100)) {
+        param_mailbox<rx_agc_params>::scoped_update p(d_params);
+        p->manual_gain = gain;
     }
 }
 
@@ -157,11 +160,9 @@ void rx_agc_cc::set_manual_gain(int gain)
  */
 void rx_agc_cc::set_slope(int slope)
 {
-    if ((slope != d_slope) && (slope >= 0) && (slope <= 10)) {
-        boost::mutex::scoped_lock lock(d_mutex);
-        d_slope = slope;
-        d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                             d_slope, d_decay, d_sample_rate);
+    if ((slope >= 0) && (slope <= 10)) {
+        param_mailbox<rx_agc_params>::scoped_update p(d_params);
+        p->slope = slope;
     }
 }
 
@@ -171,11 +172,9 @@ void rx_agc_cc::set_slope(int slope)
  */
 void rx_agc_cc::set_decay(int decay)
 {
-    if ((decay != d_decay) && (decay >= 20) && (decay <= 5000)) {
-        boost::mutex::scoped_lock lock(d_mutex);
-        d_decay = decay;
-        d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                             d_slope, d_decay, d_sample_rate);
+    if ((decay >= 20) && (decay <= 5000)) {
+        param_mailbox<rx_agc_params>::scoped_update p(d_params);
+        p->decay = decay;
     }
 }
 
@@ -185,10 +184,6 @@ void rx_agc_cc::set_decay(int decay)
  */
 void rx_agc_cc::set_use_hang(bool use_hang)
 {
-    if (use_hang != d_use_hang) {
-        boost::mutex::scoped_lock lock(d_mutex);
-        d_use_hang = use_hang;
-        d_agc->SetParameters(d_agc_on, d_use_hang, d_threshold, d_manual_gain,
-                             d_slope, d_decay, d_sample_rate);
-    }
+    param_mailbox<rx_agc_params>::scoped_update p(d_params);
+    p->use_hang = use_hang;
 }
@@ -25,8 +25,8 @@
 
 #include <gnuradio/sync_block.h>
 #include <gnuradio/gr_complex.h>
-#include <boost/thread/mutex.hpp>
 #include <dsp/agc_impl.h>
+#include <dsp/param_mailbox.h>
 
 class rx_agc_cc;
 
@@ -53,12 +53,27 @@ rx_agc_cc_sptr make_rx_agc_cc(double sample_rate, bool agc_on, int threshold,
                               int manual_gain, int slope, int decay,
                               bool use_hang);
 
+/** \brief AGC parameters handed from the setters to rx_agc_cc::work(). */
+struct rx_agc_params
+{
+    bool            agc_on;        /*! AGC status (true/false). */
+    double          sample_rate;   /*! Sample rate. */
+    int             threshold;     /*! AGC threshold (-160...0 dB). */
+    int             manual_gain;   /*! Gain when AGC is OFF. */
+    int             slope;         /*! AGC slope (0...10 dB). */
+    int             decay;         /*! AGC decay (20...5000 ms). */
+    bool            use_hang;      /*! AGC hang status (true/false). */
+};
+
 /**
  * \brief Experimental AGC block for analog voice modes (AM, SSB, CW).
  * \ingroup DSP
  *
  * This block performs automatic gain control.
- * To be written...
+ *
+ * The setters publish a new rx_agc_params snapshot through a
+ * param_mailbox; work() applies it before processing the next buffer
+ * and never waits for the setters.
  */
 class rx_agc_cc : public gr::sync_block
 {
@@ -86,16 +101,9 @@ public:
     void set_use_hang(bool use_hang);
 
 private:
-    CAgc           *d_agc;
-    boost::mutex    d_mutex;  /*! Used to lock internal data while processing or setting parameters. */
+    CAgc           *d_agc;     /*! AGC implementation, only used by work(). */
 
-    bool            d_agc_on;        /*! Current AGC status (true/false). */
-    double          d_sample_rate;   /*! Current sample rate. */
-    int             d_threshold;     /*! Current AGC threshold (-160...0 dB). */
-    int             d_manual_gain;   /*! Current gain when AGC is OFF. */
-    int             d_slope;         /*! Current AGC slope (0...10 dB). */
-    int             d_decay;         /*! Current AGC decay (20...5000 ms). */
-    bool            d_use_hang;      /*! Current AGC hang status (true/false). */
+    param_mailbox<rx_agc_params> d_params;  /*! Current AGC parameters. */
 };
 
 #endif /* RX_AGC_XX_H */
@@ -21,13 +21,59 @@
  * Boston, MA 02110-1301, USA.
  */
 #include <math.h>
+#include <string.h>
+#include <algorithm>
 #include <gnuradio/io_signature.h>
 #include <gnuradio/filter/firdes.h>
 #include <gnuradio/gr_complex.h>
-#include <gnuradio/fft/fft.h>
+#include <volk/volk.h>
 #include "dsp/rx_fft.h"
 
 
+/*! \brief Calculate FFT-shifted power spectrum from raw FFT output.
+ *  \param fft_out The FFT output (fftsize points).
+ *  \param pwr Output buffer for the power spectrum (fftsize points).
+ *  \param fftsize The FFT size.
+ *
+ * Negative frequencies come first in the output.
+ */
+static void fft_to_power(const gr_complex *fft_out, float *pwr, unsigned int fftsize)
+{
+    unsigned int half = fftsize / 2;
+
+    volk_32fc_magnitude_squared_32f(pwr, fft_out + half, fftsize - half);
+    volk_32fc_magnitude_squared_32f(pwr + fftsize - half, fft_out, half);
+}
+
+/*! \brief Convert power spectrum to dBFS in place.
+ *  \param pwr The power spectrum (fftsize points).
+ *  \param fftsize The FFT size.
+ *  \param scale Normalization factor so that full scale becomes 0 dBFS.
+ *
+ * The log calculation uses VOLK kernels; the remaining loop is simple
+ * enough for the compiler to vectorize.
+ */
+static void power_to_dbfs(float *pwr, unsigned int fftsize, float scale)
+{
+    unsigned int i;
+
+    /* normalize; the offset avoids log(0) */
+    for (i = 0; i < fftsize; i++)
+        pwr[i] = pwr[i] * scale + 1.0e-20f;
+
+    /* 10*log10(x) = 10*log10(2) * log2(x) */
+    volk_32f_log2_32f(pwr, pwr, fftsize);
+    volk_32f_s32f_multiply_32f(pwr, pwr, 3.01029996f, fftsize);
+}
+
+/*! \brief Convert raw FFT output to an FFT-shifted power spectrum in dBFS. */
+static void fft_to_dbfs(const gr_complex *fft_out, float *pwr, unsigned int fftsize)
+{
+    fft_to_power(fft_out, pwr, fftsize);
+    power_to_dbfs(pwr, fftsize, 1.0f / ((float)fftsize * (float)fftsize));
+}
+
+
 rx_fft_c_sptr make_rx_fft_c (unsigned int fftsize, int wintype)
 {
     return gnuradio::get_initial_sptr(new rx_fft_c (fftsize, wintype));
@@ -42,18 +88,29 @@ rx_fft_c::rx_fft_c(unsigned int fftsize, int wintype)
     : gr::sync_block ("rx_fft_c",
           gr::io_signature::make(1, 1, sizeof(gr_complex)),
           gr::io_signature::make(0, 0, 0)),
-      d_fftsize(fftsize),
-      d_wintype(-1)
+      d_fftsize(fftsize > MAX_FFT_SIZE ? MAX_FFT_SIZE : fftsize),
+      d_wintype(gr::filter::firdes::WIN_HAMMING),
+      d_fftavg(0.5f),
+      d_welch(false),
+      d_overlap(0.5f),
+      d_period(0),
+      d_max_avg(WELCH_MAX_AVG),
+      d_fill(0),
+      d_fft(0),
+      d_cur_wintype(-1),
+      d_iir(MAX_FFT_SIZE, -120.0f),
+      d_seg(MAX_FFT_SIZE),
+      d_seg_fill(0),
+      d_acc(MAX_FFT_SIZE),
+      d_pwr(MAX_FFT_SIZE),
+      d_navg(0),
+      d_nsamples(0),
+      d_welch_active(false)
 {
-
-    /* create FFT object */
-    d_fft = new gr::fft::fft_complex(d_fftsize, true);
-
-    /* allocate circular buffer */
-    d_cbuf.set_capacity(d_fftsize);
-
-    /* create FFT window */
     set_window_type(wintype);
+
+    /* create FFT object and window */
+    update_fft(d_fftsize);
 }
 
 rx_fft_c::~rx_fft_c()
@@ -66,134 +123,396 @@ rx_fft_c::~rx_fft_c()
  *  \param input_items
  *  \param output_items
  *
- * This method does nothing except throwing the incoming samples into the
- * circular buffer.
+ * This method does nothing except copying the incoming samples into the
+ * current write frame and publishing it once it contains fftsize samples.
+ * If the input block is longer than the FFT size only the last fftsize
+ * samples are copied, since older frames would be overwritten anyway.
  * FFT is only executed when the GUI asks for new FFT data via get_fft_data().
+ *
+ * In Welch mode the samples are passed on to welch_work() instead.
  */
 int rx_fft_c::work(int noutput_items,
                    gr_vector_const_void_star &input_items,
                    gr_vector_void_star &output_items)
 {
-    int i;
     const gr_complex *in = (const gr_complex*)input_items[0];
+    unsigned int fftsize = d_fftsize.load(boost::memory_order_relaxed);
+    unsigned int nitems = (unsigned int) noutput_items;
+    unsigned int n;
+    rx_fft_frame<gr_complex> *frame = &d_frames.write_buffer();
     (void) output_items;
 
-    /* just throw new samples into the buffer */
-    boost::mutex::scoped_lock lock(d_mutex);
-    for (i = 0; i < noutput_items; i++)
+    fft_plan_cache::mark_dsp_thread();
+
+    if (d_welch.load(boost::memory_order_relaxed))
     {
-        d_cbuf.push_back(in[i]);
+        welch_work(in, nitems);
+
+        return noutput_items;
     }
+    d_welch_active = false;
 
-    return noutput_items;
+    if (frame->size != fftsize)
+    {
+        /* FFT size has changed; start over with a new frame */
+        frame->size = fftsize;
+        d_fill = 0;
+    }
+
+    if (nitems >= fftsize)
+    {
+        /* the newest complete frame is in this block */
+        memcpy(&frame->samples[0], in + nitems - fftsize, sizeof(gr_complex)*fftsize);
+        d_frames.publish();
+        d_fill = 0;
 
+        return noutput_items;
+    }
+
+    n = fftsize - d_fill;
+    if (nitems < n)
+    {
+        memcpy(&frame->samples[d_fill], in, sizeof(gr_complex)*nitems);
+        d_fill += nitems;
+    }
+    else
+    {
+        /* complete current frame and start the next one */
+        memcpy(&frame->samples[d_fill], in, sizeof(gr_complex)*n);
+        d_frames.publish();
+
+        frame = &d_frames.write_buffer();
+        frame->size = fftsize;
+        d_fill = nitems - n;
+        memcpy(&frame->samples[0], in + n, sizeof(gr_complex)*d_fill);
+    }
+
+    return noutput_items;
 }
 
 /*! \brief Get FFT data.
- *  \param fftPoints Buffer to copy FFT data
+ *  \param fftPoints Buffer for the averaged power spectrum in dBFS.
+ *  \param wfPoints Buffer for the power spectrum of the newest frame in dBFS.
  *  \param fftSize Current FFT size (output).
+ *
+ * Both buffers must hold at least MAX_FFT_SIZE points and are FFT-shifted,
+ * i.e. ready to plot. fftSize is set to 0 if no new frame has been
+ * completed since the previous call.
+ *
+ * In Welch mode wfPoints receives the latest Welch spectrum.
  */
-void rx_fft_c::get_fft_data(std::complex<float>* fftPoints, unsigned int &fftSize)
+void rx_fft_c::get_fft_data(float *fftPoints, float *wfPoints, unsigned int &fftSize)
 {
-    boost::mutex::scoped_lock lock(d_mutex);
+    unsigned int fftsize = d_fftsize.load();
 
-    if (d_cbuf.size() < d_fftsize)
+    if (d_welch.load())
     {
-        // not enough samples in the buffer
-        fftSize = 0;
+        if (!d_spectra.fetch() || (d_spectra.read_buffer().size != fftsize))
+        {
+            fftSize = 0;
 
-        return;
+            return;
+        }
+
+        memcpy(wfPoints, &d_spectra.read_buffer().samples[0], sizeof(float)*fftsize);
     }
+    else
+    {
+        if (!d_frames.fetch() || (d_frames.read_buffer().size != fftsize))
+        {
+            // no new frame, or frame captured with old FFT size
+            fftSize = 0;
 
-    /* perform FFT */
-    do_fft(d_cbuf.linearize(), d_cbuf.size());  // FIXME: array_one() and two() may be faster
-    d_cbuf.clear();
+            return;
+        }
+
+        update_fft(fftsize);
+
+        /* perform FFT */
+        do_fft(d_fft, d_window, &d_frames.read_buffer().samples[0], fftsize);
+
+        /* get FFT data */
+        fft_to_dbfs(d_fft->get_outbuf(), wfPoints, fftsize);
+    }
+
+    /* FFT averaging (aka. video filter) */
+    float a = d_fftavg.load() / 150.0f;
+    float *iir = &d_iir[0];
+    for (unsigned int i = 0; i < fftsize; i++)
+        iir[i] += a * (150.0f + wfPoints[i]) * (wfPoints[i] - iir[i]);
 
-    /* get FFT data */
-    memcpy(fftPoints, d_fft->get_outbuf(), sizeof(gr_complex)*d_fftsize);
-    fftSize = d_fftsize;
+    memcpy(fftPoints, iir, sizeof(float)*fftsize);
+    fftSize = fftsize;
+}
+
+/*! \brief Make sure FFT object and window match the requested settings.
+ *  \param fftsize The FFT size to use.
+ *
+ * Called on the reader side so that the FFT object is never replaced
+ * while it is being used.
+ */
+void rx_fft_c::update_fft(unsigned int fftsize)
+{
+    int wintype = d_wintype.load();
+
+    if (!d_fft || (d_fft->inbuf_length() != (int)fftsize))
+    {
+        /* reset FFT object (the plan is reused from the plan cache) */
+        delete d_fft;
+        d_fft = new fft_complex_cached(fftsize, true);
+        d_cur_wintype = -1;
+    }
+
+    if (wintype != d_cur_wintype)
+    {
+        d_cur_wintype = wintype;
+        d_window.clear();
+        d_window = gr::filter::firdes::window((gr::filter::firdes::win_type)wintype, fftsize, 6.76);
+    }
 }
 
 /*! \brief Compute FFT on the available input data.
+ *  \param fft The FFT object to use.
+ *  \param window The FFT window (may be empty).
  *  \param data_in The data to compute FFT on.
  *  \param size The size of data_in.
- *
- * Note that this function does not lock the mutex since the caller, get_fft_data()
- * has alrady locked it.
  */
-void rx_fft_c::do_fft(const gr_complex *data_in, unsigned int size)
+void rx_fft_c::do_fft(fft_complex_cached *fft, const std::vector<float> &window,
+                      const gr_complex *data_in, unsigned int size)
 {
     /* apply window, if any */
-    if (d_window.size())
+    if (window.size())
     {
-        gr_complex *dst = d_fft->get_inbuf();
+        gr_complex *dst = fft->get_inbuf();
         for (unsigned int i = 0; i < size; i++)
-            dst[i] = data_in[i] * d_window[i];
+            dst[i] = data_in[i] * window[i];
     }
     else
     {
-        memcpy(d_fft->get_inbuf(), data_in, sizeof(gr_complex)*size);
+        memcpy(fft->get_inbuf(), data_in, sizeof(gr_complex)*size);
     }
 
     /* compute FFT */
-    d_fft->execute();
+    fft->execute();
 }
 
-/*! \brief Set new FFT size. */
-void rx_fft_c::set_fft_size(unsigned int fftsize)
+/*! \brief Prepare FFT object and window for Welch mode and hand them to work().
+ *
+ * Called from the setters so that FFTW planning and memory allocation never
+ * happen on the scheduler thread. A setup that work() no longer uses is
+ * released here when its slot is reused.
+ */
+void rx_fft_c::update_welch()
 {
-    if (fftsize != d_fftsize)
-    {
-        boost::mutex::scoped_lock lock(d_mutex);
+    unsigned int fftsize = d_fftsize.load();
+    rx_fft_welch_setup &setup = d_wsetup.write_buffer();
+
+    if (!setup.fft || (setup.fft->inbuf_length() != (int)fftsize))
+        setup.fft.reset(new fft_complex_cached(fftsize, true));
+    setup.window = gr::filter::firdes::window((gr::filter::firdes::win_type)d_wintype.load(),
+                                              fftsize, 6.76);
+    setup.fftsize = fftsize;
+    d_wsetup.publish();
+}
+
+/*! \brief Reset Welch state, e.g. after FFT size change. */
+void rx_fft_c::welch_reset()
+{
+    std::fill(d_acc.begin(), d_acc.end(), 0.0f);
+    d_seg_fill = 0;
+    d_navg = 0;
+    d_nsamples = 0;
+    d_welch_active = true;
+}
+
+/*! \brief Welch mode processing.
+ *  \param in The input samples.
+ *  \param nitems The number of input samples.
+ *
+ * The input is split into segments of fftsize samples that overlap by
+ * d_overlap. Each segment is windowed and transformed, and the power is
+ * accumulated until d_period samples have been processed. Once d_max_avg
+ * segments have been accumulated, the rest of the period is skipped
+ * without copying it.
+ *
+ * The FFT size is the one of the last setup published by update_welch().
+ */
+void rx_fft_c::welch_work(const gr_complex *in, unsigned int nitems)
+{
+    if (d_wsetup.fetch() || !d_welch_active)
+        welch_reset();
 
-        d_fftsize = fftsize;
+    rx_fft_welch_setup &setup = d_wsetup.read_buffer();
+    unsigned int fftsize = setup.fftsize;
+    unsigned int step = fftsize - (unsigned int)(d_overlap.load() * (float)fftsize);
+    unsigned int period = d_period.load();
+    unsigned int max_avg = d_max_avg.load();
+    unsigned int n;
 
-        /* clear and resize circular buffer */
-        d_cbuf.clear();
-        d_cbuf.set_capacity(d_fftsize);
+    if (!setup.fft)
+        return;
 
-        /* reset window */
-        int wintype = d_wintype; // FIXME: would be nicer with a window_reset()
-        d_wintype = -1;
-        set_window_type(wintype);
+    if (step < 1)
+        step = 1;
+    if (period < fftsize)
+        period = fftsize;
 
-        /* reset FFT object (also reset FFTW plan) */
-        delete d_fft;
-        d_fft = new gr::fft::fft_complex (d_fftsize, true);
+    while (nitems > 0)
+    {
+        if (d_navg >= max_avg)
+        {
+            /* enough FFTs in this period; skip to its end */
+            n = std::min(nitems, period - d_nsamples);
+            d_seg_fill = 0;
+            d_nsamples += n;
+            in += n;
+            nitems -= n;
+
+            if (d_nsamples >= period)
+                welch_publish(fftsize);
+
+            continue;
+        }
+
+        n = std::min(nitems, fftsize - d_seg_fill);
+        n = std::min(n, period - d_nsamples);
+
+        memcpy(&d_seg[d_seg_fill], in, sizeof(gr_complex)*n);
+        d_seg_fill += n;
+        d_nsamples += n;
+        in += n;
+        nitems -= n;
+
+        if (d_seg_fill == fftsize)
+        {
+            do_fft(setup.fft.get(), setup.window, &d_seg[0], fftsize);
+            fft_to_power(setup.fft->get_outbuf(), &d_pwr[0], fftsize);
+            volk_32f_x2_add_32f(&d_acc[0], &d_acc[0], &d_pwr[0], fftsize);
+            d_navg++;
+
+            /* keep the overlapping part for the next segment */
+            d_seg_fill = fftsize - step;
+            memmove(&d_seg[0], &d_seg[step], sizeof(gr_complex)*d_seg_fill);
+        }
+
+        if (d_nsamples >= period)
+            welch_publish(fftsize);
     }
+}
 
+/*! \brief Hand the current Welch spectrum over to the reader and restart averaging. */
+void rx_fft_c::welch_publish(unsigned int fftsize)
+{
+    if (d_navg > 0)
+    {
+        rx_fft_frame<float> &frame = d_spectra.write_buffer();
+
+        memcpy(&frame.samples[0], &d_acc[0], sizeof(float)*fftsize);
+        power_to_dbfs(&frame.samples[0], fftsize,
+                      1.0f / ((float)fftsize * (float)fftsize * (float)d_navg));
+        frame.size = fftsize;
+        d_spectra.publish();
+
+        memset(&d_acc[0], 0, sizeof(float)*fftsize);
+    }
+
+    d_navg = 0;
+    d_nsamples = 0;
+}
+
+/*! \brief Set new FFT size.
+ *
+ * The new size is used for the next frame captured by work() and the FFT
+ * object is recreated on the next call to get_fft_data().
+ */
+void rx_fft_c::set_fft_size(unsigned int fftsize)
+{
+    if (fftsize > MAX_FFT_SIZE)
+        fftsize = MAX_FFT_SIZE;
+
+    d_fftsize.store(fftsize);
+    update_welch();
 }
 
 /*! \brief Get currently used FFT size. */
 unsigned int rx_fft_c::get_fft_size()
 {
-    return d_fftsize;
+    return d_fftsize.load();
 }
 
 /*! \brief Set new window type. */
 void rx_fft_c::set_window_type(int wintype)
 {
-    if (wintype == d_wintype)
+    if ((wintype < gr::filter::firdes::WIN_HAMMING) || (wintype > gr::filter::firdes::WIN_BLACKMAN_hARRIS))
     {
-        /* nothing to do */
-        return;
+        wintype = gr::filter::firdes::WIN_HAMMING;
     }
 
-    d_wintype = wintype;
-
-    if ((d_wintype < gr::filter::firdes::WIN_HAMMING) || (d_wintype > gr::filter::firdes::WIN_BLACKMAN_hARRIS))
-    {
-        d_wintype = gr::filter::firdes::WIN_HAMMING;
-    }
-
-    d_window.clear();
-    d_window = gr::filter::firdes::window((gr::filter::firdes::win_type)d_wintype, d_fftsize, 6.76);
+    d_wintype.store(wintype);
+    update_welch();
 }
 
 /*! \brief Get currently used window type. */
 int rx_fft_c::get_window_type()
 {
-    return d_wintype;
+    return d_wintype.load();
+}
+
+/*! \brief Set FFT averaging parameter.
+ *  \param avg The averaging parameter between 0.0 and 1.0, where 1.0 means
+ *              no averaging. The actual IIR gain also depends on the signal
+ *              level so that strong signals respond faster.
+ */
+void rx_fft_c::set_averaging(float avg)
+{
+    if ((avg >= 0.0f) && (avg <= 1.0f))
+        d_fftavg.store(avg);
+}
+
+/*! \brief Get FFT averaging parameter. */
+float rx_fft_c::get_averaging()
+{
+    return d_fftavg.load();
+}
+
+/*! \brief Enable or disable Welch mode.
+ *  \param enable Whether to use Welch mode.
+ *  \param overlap Segment overlap between 0.0 and 0.9.
+ */
+void rx_fft_c::set_welch(bool enable, float overlap)
+{
+    if (overlap < 0.0f)
+        overlap = 0.0f;
+    else if (overlap > 0.9f)
+        overlap = 0.9f;
+
+    d_overlap.store(overlap);
+    d_welch.store(enable);
+}
+
+/*! \brief Whether Welch mode is enabled. */
+bool rx_fft_c::get_welch()
+{
+    return d_welch.load();
+}
+
+/*! \brief Set Welch averaging period.
+ *  \param nsamples Number of input samples per Welch spectrum, usually
+ *                   sample rate / display rate. Values below the FFT size
+ *                   are rounded up to the FFT size.
+ */
+void rx_fft_c::set_welch_period(unsigned int nsamples)
+{
+    d_period.store(nsamples);
+}
+
+/*! \brief Set max number of FFTs per Welch spectrum.
+ *
+ * This sets an upper bound for the CPU time used in Welch mode.
+ */
+void rx_fft_c::set_welch_max_avg(unsigned int navg)
+{
+    d_max_avg.store(navg > 0 ? navg : 1);
 }
 
 
@@ -204,7 +523,7 @@ rx_fft_f_sptr make_rx_fft_f(unsigned int fftsize, int wintype)
     return gnuradio::get_initial_sptr(new rx_fft_f (fftsize, wintype));
 }
 
-/*! \brief Create receiver FFT object.
+/*! \brief Create audio FFT object.
  *  \param fftsize The FFT size.
  *  \param wintype The window type (see gr::filter::firdes::win_type).
  *
@@ -213,18 +532,16 @@ rx_fft_f::rx_fft_f(unsigned int fftsize, int wintype)
     : gr::sync_block ("rx_fft_f",
           gr::io_signature::make(1, 1, sizeof(float)),
           gr::io_signature::make(0, 0, 0)),
-      d_fftsize(fftsize),
-      d_wintype(-1)
+      d_fftsize(fftsize > MAX_FFT_SIZE ? MAX_FFT_SIZE : fftsize),
+      d_wintype(gr::filter::firdes::WIN_HAMMING),
+      d_fill(0),
+      d_fft(0),
+      d_cur_wintype(-1)
 {
-
-    /* create FFT object */
-    d_fft = new gr::fft::fft_complex(d_fftsize, true);
-
-    /* allocate circular buffer */
-    d_cbuf.set_capacity(d_fftsize);
-
-    /* create FFT window */
     set_window_type(wintype);
+
+    /* create FFT object and window */
+    update_fft(d_fftsize);
 }
 
 rx_fft_f::~rx_fft_f()
@@ -237,134 +554,168 @@ rx_fft_f::~rx_fft_f()
  *  \param input_items
  *  \param output_items
  *
- * This method does nothing except throwing the incoming samples into the
- * circular buffer.
+ * This method does nothing except copying the incoming samples into the
+ * current write frame and publishing it once it contains fftsize samples.
+ * If the input block is longer than the FFT size only the last fftsize
+ * samples are copied, since older frames would be overwritten anyway.
  * FFT is only executed when the GUI asks for new FFT data via get_fft_data().
  */
 int rx_fft_f::work(int noutput_items,
                    gr_vector_const_void_star &input_items,
                    gr_vector_void_star &output_items)
 {
-    int i;
     const float *in = (const float*)input_items[0];
+    unsigned int fftsize = d_fftsize.load(boost::memory_order_relaxed);
+    unsigned int nitems = (unsigned int) noutput_items;
+    unsigned int n;
+    rx_fft_frame<float> *frame = &d_frames.write_buffer();
     (void) output_items;
 
-    /* just throw new samples into the buffer */
-    boost::mutex::scoped_lock lock(d_mutex);
-    for (i = 0; i < noutput_items; i++)
+    fft_plan_cache::mark_dsp_thread();
+
+    if (frame->size != fftsize)
+    {
+        /* FFT size has changed; start over with a new frame */
+        frame->size = fftsize;
+        d_fill = 0;
+    }
+
+    if (nitems >= fftsize)
+    {
+        /* the newest complete frame is in this block */
+        memcpy(&frame->samples[0], in + nitems - fftsize, sizeof(float)*fftsize);
+        d_frames.publish();
+        d_fill = 0;
+
+        return noutput_items;
+    }
+
+    n = fftsize - d_fill;
+    if (nitems < n)
+    {
+        memcpy(&frame->samples[d_fill], in, sizeof(float)*nitems);
+        d_fill += nitems;
+    }
+    else
     {
-        d_cbuf.push_back(in[i]);
+        /* complete current frame and start the next one */
+        memcpy(&frame->samples[d_fill], in, sizeof(float)*n);
+        d_frames.publish();
+
+        frame = &d_frames.write_buffer();
+        frame->size = fftsize;
+        d_fill = nitems - n;
+        memcpy(&frame->samples[0], in + n, sizeof(float)*d_fill);
     }
 
     return noutput_items;
 }
 
 /*! \brief Get FFT data.
- *  \param fftPoints Buffer to copy FFT data
- *  \param fftSize Current FFT size (output).
+ *  \param fftPoints Buffer for the power spectrum in dBFS (MAX_FFT_SIZE/2 points).
+ *  \param fftSize Number of points in the half spectrum (output), i.e.
+ *                 half of the current FFT size.
+ *
+ * Only the non-negative frequencies from 0 Hz to fs/2 are returned. fftSize
+ * is set to 0 if no new frame has been completed since the previous call.
  */
-void rx_fft_f::get_fft_data(std::complex<float>* fftPoints, unsigned int &fftSize)
+void rx_fft_f::get_fft_data(float *fftPoints, unsigned int &fftSize)
 {
-    boost::mutex::scoped_lock lock(d_mutex);
+    unsigned int fftsize = d_fftsize.load();
 
-    if (d_cbuf.size() < d_fftsize)
+    if (!d_frames.fetch() || (d_frames.read_buffer().size != fftsize))
     {
-        // not enough samples in the buffer
+        // no new frame, or frame captured with old FFT size
         fftSize = 0;
 
         return;
     }
 
+    update_fft(fftsize);
+
     /* perform FFT */
-    do_fft(d_cbuf.linearize(), d_cbuf.size());  // FIXME: array_one() and two() may be faster
-    d_cbuf.clear();
+    do_fft(&d_frames.read_buffer().samples[0], fftsize);
 
-    /* get FFT data */
-    memcpy(fftPoints, d_fft->get_outbuf(), sizeof(gr_complex)*d_fftsize);
-    fftSize = d_fftsize;
+    /* get FFT data (same scaling as the complex FFT) */
+    volk_32fc_magnitude_squared_32f(fftPoints, d_fft->get_outbuf(), fftsize / 2);
+    power_to_dbfs(fftPoints, fftsize / 2, 1.0f / ((float)fftsize * (float)fftsize));
+    fftSize = fftsize / 2;
 }
 
-/*! \brief Compute FFT on the available input data.
- *  \param data_in The data to compute FFT on.
- *  \param size The size of data_in.
+/*! \brief Make sure FFT object and window match the requested settings.
+ *  \param fftsize The FFT size to use.
  *
- * Note that this function does not lock the mutex since the caller, get_fft_data()
- * has alrady locked it.
+ * Called on the reader side so that the FFT object is never replaced
+ * while it is being used.
  */
-void rx_fft_f::do_fft(const float *data_in, unsigned int size)
+void rx_fft_f::update_fft(unsigned int fftsize)
 {
-    gr_complex *dst = d_fft->get_inbuf();
-    unsigned int i;
+    int wintype = d_wintype.load();
 
-    /* apply window, and convert to complex */
-    if (d_window.size())
+    if (!d_fft || (d_fft->inbuf_length() != (int)fftsize))
     {
-        for (i = 0; i < size; i++)
-            dst[i] = data_in[i] * d_window[i];
+        /* reset FFT object (the plan is reused from the plan cache) */
+        delete d_fft;
+        d_fft = new fft_real_cached(fftsize);
+        d_cur_wintype = -1;
     }
-    else
+
+    if (wintype != d_cur_wintype)
     {
-        for (i = 0; i < size; i++)
-            dst[i] = data_in[i];
+        d_cur_wintype = wintype;
+        d_window.clear();
+        d_window = gr::filter::firdes::window((gr::filter::firdes::win_type)wintype, fftsize, 6.76);
     }
+}
+
+/*! \brief Compute FFT on the available input data.
+ *  \param data_in The data to compute FFT on.
+ *  \param size The size of data_in.
+ */
+void rx_fft_f::do_fft(const float *data_in, unsigned int size)
+{
+    /* apply window, if any */
+    if (d_window.size())
+        volk_32f_x2_multiply_32f(d_fft->get_inbuf(), data_in, &d_window[0], size);
+    else
+        memcpy(d_fft->get_inbuf(), data_in, sizeof(float)*size);
 
     /* compute FFT */
     d_fft->execute();
 }
 
-
-/*! \brief Set new FFT size. */
+/*! \brief Set new FFT size.
+ *
+ * The new size is used for the next frame captured by work() and the FFT
+ * object is recreated on the next call to get_fft_data().
+ */
 void rx_fft_f::set_fft_size(unsigned int fftsize)
 {
-    if (fftsize != d_fftsize)
-    {
-        boost::mutex::scoped_lock lock(d_mutex);
-
-        d_fftsize = fftsize;
-
-        /* clear and resize circular buffer */
-        d_cbuf.clear();
-        d_cbuf.set_capacity(d_fftsize);
+    if (fftsize > MAX_FFT_SIZE)
+        fftsize = MAX_FFT_SIZE;
 
-        /* reset window */
-        int wintype = d_wintype; // FIXME: would be nicer with a window_reset()
-        d_wintype = -1;
-        set_window_type(wintype);
-
-        /* reset FFT object (also reset FFTW plan) */
-        delete d_fft;
-        d_fft = new gr::fft::fft_complex(d_fftsize, true);
-    }
+    d_fftsize.store(fftsize);
 }
 
 /*! \brief Get currently used FFT size. */
 unsigned int rx_fft_f::get_fft_size()
 {
-    return d_fftsize;
+    return d_fftsize.load();
 }
 
 /*! \brief Set new window type. */
 void rx_fft_f::set_window_type(int wintype)
 {
-    if (wintype == d_wintype)
-    {
-        /* nothing to do */
-        return;
-    }
-
-    d_wintype = wintype;
-
-    if ((d_wintype < gr::filter::firdes::WIN_HAMMING) || (d_wintype > gr::filter::firdes::WIN_BLACKMAN_hARRIS))
+    if ((wintype < gr::filter::firdes::WIN_HAMMING) || (wintype > gr::filter::firdes::WIN_BLACKMAN_hARRIS))
     {
-        d_wintype = gr::filter::firdes::WIN_HAMMING;
+        wintype = gr::filter::firdes::WIN_HAMMING;
     }
 
-    d_window.clear();
-    d_window = gr::filter::firdes::window((gr::filter::firdes::win_type)d_wintype, d_fftsize, 6.76);
+    d_wintype.store(wintype);
 }
 
 /*! \brief Get currently used window type. */
 int rx_fft_f::get_window_type()
 {
-    return d_wintype;
+    return d_wintype.load();
 }
@@ -24,15 +24,39 @@
 #define RX_FFT_H
 
 #include <gnuradio/sync_block.h>
-#include <gnuradio/fft/fft.h>
 #include <gnuradio/filter/firdes.h>       /* contains enum win_type */
 #include <gnuradio/gr_complex.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/circular_buffer.hpp>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include "dsp/fft_plan_cache.h"
+#include "dsp/triple_buffer.h"
 
 
 #define MAX_FFT_SIZE 32768
 
+#define WELCH_MAX_AVG 128  /*!< Default max number of FFTs per Welch spectrum. */
+
+/*! \brief Block of input samples handed from work() to the FFT reader. */
+template <class T>
+struct rx_fft_frame
+{
+    std::vector<T> samples;  /*!< Sample storage, MAX_FFT_SIZE long. */
+    unsigned int   size;     /*!< Number of valid samples, i.e. FFT size at capture time. */
+
+    rx_fft_frame() : samples(MAX_FFT_SIZE), size(0) {}
+};
+
+/*! \brief FFT object and window for Welch mode, prepared outside work(). */
+struct rx_fft_welch_setup
+{
+    boost::shared_ptr<fft_complex_cached> fft;  /*!< FFT object of fftsize points. */
+    std::vector<float>  window;                 /*!< FFT window taps. */
+    unsigned int        fftsize;                /*!< FFT size, 0 if not set up. */
+
+    rx_fft_welch_setup() : fftsize(0) {}
+};
+
 class rx_fft_c;
 class rx_fft_f;
 
@@ -56,10 +80,35 @@ rx_fft_c_sptr make_rx_fft_c(unsigned int fftsize=4096, int wintype=gr::filter::f
  *
  * This block is used to compute the FFT of the received spectrum.
  *
- * The samples are collected in a cicular buffer with size FFT_SIZE.
- * When the GUI asks for a new set of FFT data via get_fft_data() an FFT
- * will be performed on the data stored in the circular buffer - assuming
- * of course that the buffer contains at least fftsize samples.
+ * work() copies the incoming samples into frames of fftsize samples and
+ * publishes each complete frame through a lock-free triple buffer. When
+ * the GUI asks for a new set of FFT data via get_fft_data() an FFT will be
+ * performed on the newest complete frame - assuming of course that a new
+ * frame has been published since the previous call.
+ *
+ * get_fft_data() returns FFT-shifted power spectra in dBFS: the power of
+ * the newest frame for the waterfall and an averaged spectrum ("video
+ * filter", see set_averaging()) for the pandapter.
+ *
+ * In Welch mode (see set_welch()) the FFTs are instead computed in work()
+ * on overlapping segments of the input and the power is averaged over
+ * set_welch_period() samples before being handed to the reader. The
+ * number of FFTs per period is limited by set_welch_max_avg(), which
+ * bounds the CPU usage independently of the sample rate.
+ *
+ * work() and get_fft_data() never block each other. FFT size and window
+ * changes are picked up lazily by the side that needs them, so
+ * get_fft_data() must only be called from one thread at a time. The FFT
+ * object and window used by work() in Welch mode are created by
+ * set_fft_size() and set_window_type() and handed over through a triple
+ * buffer, so work() never plans an FFT or allocates memory. These two
+ * setters must therefore only be called from one thread at a time.
+ *
+ * The settings are not kept in a param_mailbox like in rx_agc_cc and
+ * rx_nb_cc, because a mailbox has a single reader and both work() and
+ * get_fft_data() read them. Each one is a separate atomic instead:
+ * d_fftsize and d_welch are read by both sides, d_wintype and d_fftavg by
+ * get_fft_data(), and d_overlap, d_period and d_max_avg by work().
  *
  * \note Uses code from qtgui_sink_c
  */
@@ -77,7 +126,7 @@ public:
              gr_vector_const_void_star &input_items,
              gr_vector_void_star &output_items);
 
-    void get_fft_data(std::complex<float>* fftPoints, unsigned int &fftSize);
+    void get_fft_data(float *fftPoints, float *wfPoints, unsigned int &fftSize);
 
     void set_window_type(int wintype);
     int  get_window_type();
@@ -85,18 +134,51 @@ public:
     void set_fft_size(unsigned int fftsize);
     unsigned int get_fft_size();
 
-private:
-    unsigned int d_fftsize;   /*! Current FFT size. */
-    int          d_wintype;   /*! Current window type. */
+    void set_averaging(float avg);
+    float get_averaging();
 
-    boost::mutex d_mutex;  /*! Used to lock FFT output buffer. */
+    void set_welch(bool enable, float overlap);
+    bool get_welch();
+    void set_welch_period(unsigned int nsamples);
+    void set_welch_max_avg(unsigned int navg);
 
-    gr::fft::fft_complex    *d_fft;    /*! FFT object. */
+private:
+    boost::atomic<unsigned int> d_fftsize;  /*! Requested FFT size. */
+    boost::atomic<int>          d_wintype;  /*! Requested window type. */
+    boost::atomic<float>        d_fftavg;   /*! FFT averaging parameter (not the true gain). */
+    boost::atomic<bool>         d_welch;    /*! Welch mode enabled. */
+    boost::atomic<float>        d_overlap;  /*! Welch segment overlap (0.0 to 0.9). */
+    boost::atomic<unsigned int> d_period;   /*! Samples per Welch spectrum. */
+    boost::atomic<unsigned int> d_max_avg;  /*! Max number of FFTs per Welch spectrum. */
+
+    /* writer side, only touched by work() */
+    triple_buffer< rx_fft_frame<gr_complex> > d_frames; /*! Frames passed to the reader. */
+    unsigned int d_fill;      /*! Number of samples in the current write frame. */
+
+    /* reader side, only touched by get_fft_data() */
+    fft_complex_cached  *d_fft;    /*! FFT object. */
     std::vector<float>  d_window; /*! FFT window taps. */
-
-    boost::circular_buffer<gr_complex> d_cbuf; /*! buffer to accumulate samples. */
-
-    void do_fft(const gr_complex *data_in, unsigned int size);
+    int          d_cur_wintype;  /*! Window type used for d_window. */
+    std::vector<float>  d_iir;    /*! Averaged spectrum in dBFS. */
+
+    /* Welch mode, only touched by work() */
+    triple_buffer< rx_fft_frame<float> > d_spectra; /*! Welch spectra passed to the reader. */
+    triple_buffer<rx_fft_welch_setup>    d_wsetup;  /*! FFT setup from the setters. */
+    std::vector<gr_complex> d_seg;       /*! Current segment. */
+    unsigned int d_seg_fill;             /*! Number of samples in d_seg. */
+    std::vector<float>  d_acc;           /*! Accumulated power (shifted). */
+    std::vector<float>  d_pwr;           /*! Power of the latest segment (shifted). */
+    unsigned int d_navg;                 /*! Number of FFTs in d_acc. */
+    unsigned int d_nsamples;             /*! Samples since last Welch spectrum. */
+    bool         d_welch_active;         /*! Welch state is initialized. */
+
+    void update_fft(unsigned int fftsize);
+    void do_fft(fft_complex_cached *fft, const std::vector<float> &window,
+                const gr_complex *data_in, unsigned int size);
+    void update_welch();
+    void welch_reset();
+    void welch_work(const gr_complex *in, unsigned int nitems);
+    void welch_publish(unsigned int fftsize);
 
 };
 
@@ -118,10 +200,13 @@ rx_fft_f_sptr make_rx_fft_f(unsigned int fftsize=1024, int wintype=gr::filter::f
  * This block is used to compute the FFT of the audio spectrum or anything
  * else where real FFT is useful.
  *
- * The samples are collected in a cicular buffer with size FFT_SIZE.
- * When the GUI asks for a new set of FFT data using get_fft_data() an FFT
- * will be performed on the data stored in the circular buffer - assuming
- * that the buffer contains at least fftsize samples.
+ * Samples are handed over to the GUI the same way as in rx_fft_c, i.e.
+ * through a lock-free triple buffer holding frames of fftsize samples.
+ *
+ * Since the input is real, a real-to-complex transform is used and
+ * get_fft_data() returns only the non-negative half of the power spectrum
+ * in dBFS, i.e. fftsize/2 points from 0 Hz up to (but not including) half
+ * the sample rate.
  *
  * \note Uses code from qtgui_sink_f
  */
@@ -139,7 +224,7 @@ public:
              gr_vector_const_void_star &input_items,
              gr_vector_void_star &output_items);
 
-    void get_fft_data(std::complex<float>* fftPoints, unsigned int &fftSize);
+    void get_fft_data(float *fftPoints, unsigned int &fftSize);
 
     void set_window_type(int wintype);
     int  get_window_type();
@@ -148,16 +233,19 @@ public:
     unsigned int  get_fft_size();
 
 private:
-    unsigned int d_fftsize;   /*! Current FFT size. */
-    int          d_wintype;   /*! Current window type. */
+    boost::atomic<unsigned int> d_fftsize;  /*! Requested FFT size. */
+    boost::atomic<int>          d_wintype;  /*! Requested window type. */
 
-    boost::mutex d_mutex;  /*! Used to lock FFT output buffer. */
+    /* writer side, only touched by work() */
+    triple_buffer< rx_fft_frame<float> > d_frames; /*! Frames passed to the reader. */
+    unsigned int d_fill;      /*! Number of samples in the current write frame. */
 
-    gr::fft::fft_complex    *d_fft;    /*! FFT object. */
+    /* reader side, only touched by get_fft_data() */
+    fft_real_cached     *d_fft;    /*! FFT object. */
     std::vector<float>  d_window; /*! FFT window taps. */
+    int          d_cur_wintype;  /*! Window type used for d_window. */
 
-    boost::circular_buffer<float> d_cbuf; /*! buffer to accumulate samples. */
-
+    void update_fft(unsigned int fftsize);
     void do_fft(const float *data_in, unsigned int size);
 
 };
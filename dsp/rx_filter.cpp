@@ -20,8 +20,17 @@
  * the Free Software Foundation, Inc., 51 Franklin Street,
  * Boston, MA 02110-1301, USA.
  */
+#include <algorithm>
 #include <cmath>
+#include <list>
+#include <map>
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
 #include <gnuradio/io_signature.h>
+#include <gnuradio/filter/fft_filter.h>
+#include <gnuradio/filter/fir_filter.h>
 #include <gnuradio/filter/firdes.h>
 #include <iostream>
 #include "dsp/rx_filter.h"
@@ -31,6 +40,353 @@ static const int MAX_IN = 1;  /* Maximum number of input streams. */
 static const int MIN_OUT = 1; /* Minimum number of output streams. */
 static const int MAX_OUT = 1; /* Maximum number of output streams. */
 
+static const unsigned int TAP_CACHE_SIZE = 32; /* Max number of cached tap sets. */
+
+static const unsigned int FFT_THRESHOLD_COMPLEX = 64; /* FFT filter from this many complex taps until measured. */
+static const unsigned int FFT_THRESHOLD_REAL = 128;   /* FFT filter from this many real taps until measured. */
+static const unsigned int FFT_MIN_TAPS = 16;          /* Shortest filter tried in the FFT benchmark. */
+static const unsigned int FFT_MAX_TAPS = 4096;        /* Longest filter tried in the FFT benchmark. */
+static const int          FFT_BENCH_RUNS = 5;         /* Runs per kernel, the fastest one counts. */
+
+
+/*! \brief Process-wide LRU cache of complex band pass filter taps.
+ *
+ * Shared by all rx_filter instances and safe to use from any thread.
+ */
+class tap_cache
+{
+public:
+    static void get_taps(std::vector<gr_complex> &taps, double sample_rate,
+                         double low, double high, double trans_width);
+
+private:
+    struct key
+    {
+        double rate, low, high, tw;
+
+        bool operator<(const key &other) const
+        {
+            if (rate != other.rate)
+                return rate < other.rate;
+            if (low != other.low)
+                return low < other.low;
+            if (high != other.high)
+                return high < other.high;
+            return tw < other.tw;
+        }
+    };
+
+    typedef std::list<std::pair<key, std::vector<gr_complex> > > entry_list;
+    typedef std::map<key, entry_list::iterator> entry_map;
+
+    static boost::mutex d_mutex;    /*! Protects the cache. */
+    static entry_list   d_entries;  /*! Entries, most recently used first. */
+    static entry_map    d_index;    /*! Entries by key. */
+};
+
+boost::mutex          tap_cache::d_mutex;
+tap_cache::entry_list tap_cache::d_entries;
+tap_cache::entry_map  tap_cache::d_index;
+
+/*! \brief Get band pass filter taps from the cache, designing them if necessary.
+ *  \param taps Vector to copy the taps into.
+ *
+ * The design itself is done without holding the cache lock so that
+ * filters in different threads do not wait for each other.
+ */
+void tap_cache::get_taps(std::vector<gr_complex> &taps, double sample_rate,
+                         double low, double high, double trans_width)
+{
+    key k = { sample_rate, low, high, trans_width };
+
+    {
+        boost::mutex::scoped_lock lock(d_mutex);
+        entry_map::iterator it = d_index.find(k);
+
+        if (it != d_index.end())
+        {
+            d_entries.splice(d_entries.begin(), d_entries, it->second);
+            taps = it->second->second;
+            return;
+        }
+    }
+
+    taps = gr::filter::firdes::complex_band_pass(1.0, sample_rate, low, high, trans_width);
+
+    boost::mutex::scoped_lock lock(d_mutex);
+
+    if (d_index.find(k) != d_index.end())
+        return;
+
+    d_entries.push_front(std::make_pair(k, taps));
+    d_index[k] = d_entries.begin();
+    if (d_entries.size() > TAP_CACHE_SIZE)
+    {
+        d_index.erase(d_entries.back().first);
+        d_entries.pop_back();
+    }
+}
+
+
+/*! \brief Measured FFT thresholds for complex and real taps, 0 until measured. */
+static boost::atomic<unsigned int> fft_measured[2];
+
+/*! \brief Time a filter kernel.
+ *  \return The shortest of FFT_BENCH_RUNS runs in microseconds.
+ */
+template <class K>
+static long time_kernel(K &kernel, gr_complex *out, const gr_complex *in, int nitems,
+                        void (*run)(K &, gr_complex *, const gr_complex *, int))
+{
+    long best = 0;
+
+    for (int i = 0; i < FFT_BENCH_RUNS; i++)
+    {
+        boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+        run(kernel, out, in, nitems);
+        long t = (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds();
+        if ((i == 0) || (t < best))
+            best = t;
+    }
+
+    return best;
+}
+
+static void run_fir(gr::filter::kernel::fir_filter_ccc &fir, gr_complex *out,
+                    const gr_complex *in, int nitems)
+{
+    fir.filterN(out, in, nitems);
+}
+
+static void run_fir_real(gr::filter::kernel::fir_filter_ccf &fir, gr_complex *out,
+                         const gr_complex *in, int nitems)
+{
+    fir.filterN(out, in, nitems);
+}
+
+static void run_fft(gr::filter::kernel::fft_filter_ccc &fft, gr_complex *out,
+                    const gr_complex *in, int nitems)
+{
+    fft.filter(nitems, in, out);
+}
+
+/*! \brief Time the direct form and FFT kernels with doubling tap counts.
+ *  \param real Compare with a direct form filter with real taps.
+ *  \return The smallest tap count at which the FFT filter was faster.
+ *
+ * Runs on the filter_designer thread while it has nothing else to do.
+ */
+static unsigned int measure_fft_threshold(bool real)
+{
+    for (unsigned int ntaps = FFT_MIN_TAPS; ntaps < FFT_MAX_TAPS; ntaps *= 2)
+    {
+        std::vector<gr_complex> taps(ntaps, gr_complex(1.0f / ntaps, 0.0f));
+        std::vector<float> rtaps(ntaps, 1.0f / ntaps);
+        gr::filter::kernel::fft_filter_ccc fft(1, taps);
+
+        /* the FFT kernel processes blocks of nsamples */
+        int nsamples = fft.set_taps(taps);
+        int nitems = std::max(nsamples, (8192 / nsamples) * nsamples);
+        std::vector<gr_complex> in(nitems + ntaps, gr_complex(0.5f, -0.5f));
+        std::vector<gr_complex> out(nitems);
+        long t_fir;
+
+        if (real)
+        {
+            gr::filter::kernel::fir_filter_ccf fir(1, rtaps);
+            t_fir = time_kernel(fir, &out[0], &in[0], nitems, run_fir_real);
+        }
+        else
+        {
+            gr::filter::kernel::fir_filter_ccc fir(1, taps);
+            t_fir = time_kernel(fir, &out[0], &in[0], nitems, run_fir);
+        }
+
+        if (time_kernel(fft, &out[0], &in[0], nitems, run_fft) < t_fir)
+            return ntaps;
+    }
+
+    return FFT_MAX_TAPS;
+}
+
+/*! \brief Get the number of taps from which FFT filtering is used.
+ *  \param real Compare with a direct form filter with real taps.
+ *
+ * The crossover is measured once per process by the filter_designer
+ * thread, see measure_fft_threshold(). Until the result is ready a fixed
+ * estimate is used: 64 complex and 128 real taps.
+ */
+static unsigned int fft_threshold(bool real)
+{
+    unsigned int threshold = fft_measured[real].load();
+
+    if (threshold > 0)
+        return threshold;
+
+    return real ? FFT_THRESHOLD_REAL : FFT_THRESHOLD_COMPLEX;
+}
+
+
+/*! \brief Tap design worker shared by all rx_filter instances.
+ *
+ * Each filter has at most one pending request, stored in the filter
+ * itself; a new request replaces one that has not been started yet.
+ * The worker thread is started on first use and runs for the lifetime
+ * of the process. The first time the queue runs empty it measures the
+ * FIR/FFT crossover, so the benchmark never delays a design.
+ */
+class filter_designer
+{
+public:
+    static void request(rx_filter *filter, double low, double high, double trans_width);
+    static void cancel(rx_filter *filter);
+
+private:
+    filter_designer();
+
+    static filter_designer &instance();
+    void run();
+
+    boost::mutex                d_mutex;  /*! Protects the queue and the requests. */
+    boost::condition_variable   d_work;   /*! Signals a new request. */
+    boost::condition_variable   d_done;   /*! Signals a finished design. */
+    std::list<rx_filter *>      d_queue;  /*! Filters with a pending request. */
+    rx_filter                  *d_busy;   /*! Filter being designed, if any. */
+    bool                        d_measured; /*! FFT thresholds have been measured. */
+
+    void measure();
+};
+
+filter_designer::filter_designer()
+    : d_busy(0),
+      d_measured(false)
+{
+    boost::thread worker(&filter_designer::run, this);
+    worker.detach();
+}
+
+/*! \brief Get the designer, starting the worker thread on first use.
+ *
+ * The instance is never destroyed, so the detached worker never waits on
+ * a destroyed condition variable during process exit.
+ */
+filter_designer &filter_designer::instance()
+{
+    static filter_designer *designer = new filter_designer();
+
+    return *designer;
+}
+
+/*! \brief Queue a tap design for a filter, replacing a pending one. */
+void filter_designer::request(rx_filter *filter, double low, double high, double trans_width)
+{
+    filter_designer &d = instance();
+
+    {
+        boost::mutex::scoped_lock lock(d.d_mutex);
+
+        filter->d_req_low = low;
+        filter->d_req_high = high;
+        filter->d_req_tw = trans_width;
+        if (!filter->d_pending)
+        {
+            filter->d_pending = true;
+            d.d_queue.push_back(filter);
+        }
+    }
+    d.d_work.notify_one();
+}
+
+/*! \brief Drop the pending request of a filter and wait until it is not being designed. */
+void filter_designer::cancel(rx_filter *filter)
+{
+    filter_designer &d = instance();
+    boost::mutex::scoped_lock lock(d.d_mutex);
+
+    if (filter->d_pending)
+    {
+        d.d_queue.remove(filter);
+        filter->d_pending = false;
+    }
+
+    while (d.d_busy == filter)
+        d.d_done.wait(lock);
+}
+
+void filter_designer::run()
+{
+    boost::mutex::scoped_lock lock(d_mutex);
+
+    while (true)
+    {
+        if (d_queue.empty() && !d_measured)
+        {
+            lock.unlock();
+            measure();
+            lock.lock();
+            d_measured = true;
+            continue;
+        }
+
+        while (d_queue.empty())
+            d_work.wait(lock);
+
+        rx_filter *filter = d_queue.front();
+        double low = filter->d_req_low;
+        double high = filter->d_req_high;
+        double tw = filter->d_req_tw;
+
+        d_queue.pop_front();
+        filter->d_pending = false;
+        d_busy = filter;
+
+        lock.unlock();
+        try
+        {
+            filter->design(low, high, tw);
+        }
+        catch (std::exception &e)
+        {
+            std::cerr << "rx_filter: " << e.what() << std::endl;
+        }
+        lock.lock();
+
+        d_busy = 0;
+        d_done.notify_all();
+    }
+}
+
+
+/*! \brief Measure the FFT thresholds and publish them to fft_threshold().
+ *
+ * Filters that exist already pick up the new thresholds with their next
+ * design.
+ */
+void filter_designer::measure()
+{
+    for (int real = 0; real < 2; real++)
+    {
+        fft_measured[real].store(measure_fft_threshold(real));
+
+#ifndef QT_NO_DEBUG_OUTPUT
+        std::cout << "rx_filter: using FFT filter from " << fft_measured[real].load()
+                  << (real ? " real" : " complex") << " taps" << std::endl;
+#endif
+    }
+}
+
+
+/*! \brief Get the real part of complex taps. */
+static std::vector<float> real_taps(const std::vector<gr_complex> &taps)
+{
+    std::vector<float> rtaps(taps.size());
+
+    for (unsigned int i = 0; i < taps.size(); i++)
+        rtaps[i] = taps[i].real();
+
+    return rtaps;
+}
+
 
 /*
  * Create a new instance of rx_filter and return
@@ -49,27 +405,44 @@ rx_filter::rx_filter(double sample_rate, double low, double high, double trans_w
       d_low(low),
       d_high(high),
       d_trans_width(trans_width),
-      d_cw_offset(0)
+      d_cw_offset(0),
+      d_type(FILTER_FIR),
+      d_pending(false)
 {
+    std::vector<gr_complex> taps;
+
     if (low < -0.95*sample_rate/2.0)
         d_low = -0.95*sample_rate/2.0;
     if (high > 0.95*sample_rate/2.0)
         d_high = 0.95*sample_rate/2.0;
 
     /* generate taps */
-    d_taps = gr::filter::firdes::complex_band_pass(1.0, d_sample_rate, d_low, d_high, d_trans_width);
-
-    /* create band pass filter */
-    d_bpf = gr::filter::fir_filter_ccc::make(1, d_taps);
-
-    /* connect filter */
-    connect(self(), 0, d_bpf, 0);
-    connect(d_bpf, 0, self(), 0);
+    tap_cache::get_taps(taps, d_sample_rate, d_low, d_high, d_trans_width);
+    d_type = choose_filter(taps);
+
+    /* create all band pass filters; the idle ones get taps when selected */
+    d_bpf = gr::filter::fir_filter_ccc::make(1, taps);
+    d_real_bpf = gr::filter::fir_filter_ccf::make(1, real_taps(taps));
+    d_fft_bpf = gr::filter::fft_filter_ccc::make(1, taps);
+    d_demux = make_rx_demux(sizeof(gr_complex), FILTER_NUM);
+    d_select = make_rx_select(sizeof(gr_complex), FILTER_NUM);
+    d_demux->set_output(d_type);
+    d_select->set_input(d_type);
+
+    /* connect filters */
+    connect(self(), 0, d_demux, 0);
+    connect(d_demux, FILTER_FIR, d_bpf, 0);
+    connect(d_demux, FILTER_FIR_REAL, d_real_bpf, 0);
+    connect(d_demux, FILTER_FFT, d_fft_bpf, 0);
+    connect(d_bpf, 0, d_select, FILTER_FIR);
+    connect(d_real_bpf, 0, d_select, FILTER_FIR_REAL);
+    connect(d_fft_bpf, 0, d_select, FILTER_FFT);
+    connect(d_select, 0, self(), 0);
 }
 
 rx_filter::~rx_filter ()
 {
-
+    filter_designer::cancel(this);
 }
 
 void rx_filter::set_param(double low, double high, double trans_width)
@@ -83,21 +456,105 @@ void rx_filter::set_param(double low, double high, double trans_width)
     if (d_high > 0.95*d_sample_rate/2.0)
         d_high = 0.95*d_sample_rate/2.0;
 
-    /* generate new taps */
-    d_taps = gr::filter::firdes::complex_band_pass(1.0, d_sample_rate,
-                                                   d_low + d_cw_offset,
-                                                   d_high + d_cw_offset,
-                                                   d_trans_width);
+    filter_designer::request(this, d_low + d_cw_offset, d_high + d_cw_offset, d_trans_width);
+}
+
+/*! \brief Design new taps and load them. Called by the filter_designer thread.
+ *
+ * The taps are loaded into the implementation that suits them best before
+ * the data is routed through it, so the switch happens at a block boundary
+ * without locking the flow graph.
+ */
+void rx_filter::design(double low, double high, double trans_width)
+{
+    std::vector<gr_complex> taps;
+
+    tap_cache::get_taps(taps, d_sample_rate, low, high, trans_width);
 
 #ifndef QT_NO_DEBUG_OUTPUT
-    std::cout << "Generating taps for new filter   LO:" << d_low
-              << "   HI:" << d_high << " TW:" << d_trans_width
-              << "   Taps: " << d_taps.size() << std::endl;
+    std::cout << "Generating taps for new filter   LO:" << low
+              << "   HI:" << high << " TW:" << trans_width
+              << "   Taps: " << taps.size() << std::endl;
 #endif
 
-    d_bpf->set_taps(d_taps);
+    filter_type type = choose_filter(taps);
+    load_taps(type, taps);
+
+    if (type != d_type)
+    {
+        d_select->set_input(type);
+        d_demux->set_output(type);
+
+        boost::mutex::scoped_lock lock(d_mutex);
+        d_type = type;
+
+#ifndef QT_NO_DEBUG_OUTPUT
+        std::cout << "rx_filter: switched to filter type " << d_type << std::endl;
+#endif
+    }
 }
 
+/*! \brief Get the best filter implementation for a set of taps.
+ *
+ * complex_band_pass() with a passband centred at 0 Hz has exactly real taps.
+ * An FFT filter is kept until the tap count drops below 3/4 of the
+ * threshold, so that dragging a filter edge around the threshold does not
+ * switch back and forth.
+ */
+rx_filter::filter_type rx_filter::choose_filter(const std::vector<gr_complex> &taps)
+{
+    bool real = true;
+    unsigned int threshold;
+
+    for (unsigned int i = 0; real && (i < taps.size()); i++)
+        real = (taps[i].imag() == 0.0f);
+
+    threshold = fft_threshold(real);
+    if (d_type == FILTER_FFT)
+        threshold = threshold * 3 / 4;
+
+    if (taps.size() >= threshold)
+        return FILTER_FFT;
+
+    return real ? FILTER_FIR_REAL : FILTER_FIR;
+}
+
+/*! \brief Load taps into one of the filter blocks. Safe while the graph runs. */
+void rx_filter::load_taps(filter_type type, const std::vector<gr_complex> &taps)
+{
+    switch (type)
+    {
+    case FILTER_FIR_REAL:
+        d_real_bpf->set_taps(real_taps(taps));
+        break;
+
+    case FILTER_FFT:
+        d_fft_bpf->set_taps(taps);
+        break;
+
+    case FILTER_FIR:
+    default:
+        d_bpf->set_taps(taps);
+        break;
+    }
+}
+
+/*! \brief Get the filter block currently in use, e.g. for performance monitoring. */
+gr::basic_block_sptr rx_filter::get_filter_block()
+{
+    boost::mutex::scoped_lock lock(d_mutex);
+
+    switch (d_type)
+    {
+    case FILTER_FIR_REAL:
+        return d_real_bpf;
+    case FILTER_FFT:
+        return d_fft_bpf;
+    case FILTER_FIR:
+    default:
+        return d_bpf;
+    }
+}
 
 void rx_filter::set_cw_offset(double offset)
 {
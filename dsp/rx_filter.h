@@ -23,9 +23,14 @@
 #ifndef RX_FILTER_H
 #define RX_FILTER_H
 
+#include <vector>
+#include <boost/thread/mutex.hpp>
 #include <gnuradio/hier_block2.h>
+#include <gnuradio/filter/fft_filter_ccc.h>
 #include <gnuradio/filter/fir_filter_ccc.h>
+#include <gnuradio/filter/fir_filter_ccf.h>
 #include <gnuradio/filter/freq_xlating_fir_filter_ccc.h>
+#include "dsp/rx_select.h"
 
 
 #define RX_FILTER_MIN_WIDTH 100  /*! Minimum width of filter */
@@ -63,10 +68,27 @@ rx_filter_sptr make_rx_filter(double sample_rate,
  * performed by the accessors (though the taps generator from gr::filter::firdes does perform
  * some sanity checks and throws std::out_of_range in case of bad parameter).
  *
+ * Sharp filters need thousands of taps, so set_param() and set_cw_offset()
+ * only queue a request and return. The taps are designed by a worker thread
+ * shared by all filters; if several requests for a filter arrive while a
+ * design is running only the last one is used. Designed taps are kept in a
+ * small process-wide LRU cache so that returning to a previous shape does
+ * not design it again.
+ *
+ * Long filters are run as overlap-save FFT filters instead of direct form
+ * FIR filters. The tap count at which this pays off is measured once by the
+ * design worker; a fixed estimate is used until then. Passbands centred
+ * at 0 Hz (e.g. AM and FM) have real taps and use a filter with real
+ * taps, which needs half the multiplications per tap. All three implementations stay connected
+ * between an rx_demux and an rx_select; only the one in use receives data.
+ * The worker loads the new taps and switches implementation without
+ * locking the flow graph.
+ *
  * \note In order to have proper LSB/USB, we must exchange low and high and reverse their sign
  */
 class rx_filter : public gr::hier_block2
 {
+    friend class filter_designer;
 
 public:
     rx_filter(double sample_rate=96000.0, double low=-5000.0, double high=5000.0, double trans_width=1000.0); // FIXME: should be private
@@ -75,15 +97,41 @@ public:
     void set_param(double low, double high, double trans_width);
     void set_cw_offset(double offset);
 
+    gr::basic_block_sptr get_filter_block();
+
 private:
-    std::vector<gr_complex> d_taps;
-    gr::filter::fir_filter_ccc::sptr  d_bpf;
+    /*! \brief Filter implementations, also the rx_demux/rx_select port. */
+    enum filter_type {
+        FILTER_FIR      = 0,  /*!< Direct form, complex taps. */
+        FILTER_FIR_REAL = 1,  /*!< Direct form, real taps. */
+        FILTER_FFT      = 2,  /*!< Overlap-save FFT filter, complex taps. */
+        FILTER_NUM      = 3   /*!< Number of implementations. */
+    };
+
+    gr::filter::fir_filter_ccc::sptr  d_bpf;       /*! Direct form filter. */
+    gr::filter::fir_filter_ccf::sptr  d_real_bpf;  /*! Real tap filter. */
+    gr::filter::fft_filter_ccc::sptr  d_fft_bpf;   /*! FFT filter. */
+    rx_demux_sptr                     d_demux;     /*! Feeds the filter in use. */
+    rx_select_sptr                    d_select;    /*! Output of the filter in use. */
 
     double d_sample_rate;
     double d_low;
     double d_high;
     double d_trans_width;
     double d_cw_offset;
+
+    boost::mutex  d_mutex;   /*! Protects d_type. */
+    filter_type   d_type;    /*! Implementation in use, written by the worker. */
+
+    /* tap design request, protected by the filter_designer lock */
+    bool    d_pending;   /*! A request is queued. */
+    double  d_req_low;   /*! Requested lower edge incl. CW offset. */
+    double  d_req_high;  /*! Requested upper edge incl. CW offset. */
+    double  d_req_tw;    /*! Requested transition width. */
+
+    void design(double low, double high, double trans_width);
+    filter_type choose_filter(const std::vector<gr_complex> &taps);
+    void load_taps(filter_type type, const std::vector<gr_complex> &taps);
 };
 
 
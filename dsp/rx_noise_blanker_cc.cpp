@@ -22,16 +22,40 @@
  * Boston, MA 02110-1301, USA.
  */
 #include <math.h>
+#include <string.h>
+#include <algorithm>
 #include <gnuradio/io_signature.h>
 #include <gnuradio/gr_complex.h>
+#include <volk/volk.h>
 #include "dsp/rx_noise_blanker_cc.h"
 
+/* Poles of the DTTSP averages */
+#define NB_MAG_POLE 0.999
+#define NB_SIG_POLE 0.75
+
+/* Delay of NB1 in samples */
+#define NB1_DELAY 2
+
 rx_nb_cc_sptr make_rx_nb_cc(double sample_rate, float thld1, float thld2)
 {
     return gnuradio::get_initial_sptr(new rx_nb_cc(sample_rate, thld1, thld2));
 }
 
 
+static rx_nb_params nb_params(double sample_rate, float thld1, float thld2)
+{
+    rx_nb_params p;
+
+    p.nb1_on = false;
+    p.nb2_on = false;
+    p.sample_rate = sample_rate;
+    p.thld_nb1 = thld1;
+    p.thld_nb2 = thld2;
+
+    return p;
+}
+
+
 /*! \brief Create noise blanker object.
  *
  * Use make_rx_nb_cc() instead.
@@ -40,18 +64,27 @@ rx_nb_cc::rx_nb_cc(double sample_rate, float thld1, float thld2)
     : gr::sync_block ("rx_nb_cc",
           gr::io_signature::make(1, 1, sizeof(gr_complex)),
           gr::io_signature::make(1, 1, sizeof(gr_complex))),
-      d_nb1_on(false),
-      d_nb2_on(false),
-      d_sample_rate(sample_rate),
-      d_thld_nb1(thld1),
-      d_thld_nb2(thld2),
+      d_params(nb_params(sample_rate, thld1, thld2)),
       d_avgmag_nb1(1.0),
       d_avgmag_nb2(1.0),
-      d_delidx(2),
-      d_sigidx(0),
+      d_avgsig(0.0, 0.0),
       d_hangtime(0)
 {
-    memset(d_delay, 0, 8 * sizeof(gr_complex));
+    set_history(NB1_DELAY + 1);
+
+    /* Tap k is the weight of the sample NB_CHUNK-1-k samples before the end
+     * of a chunk, so the last n taps advance an average by n samples.
+     */
+    for (int k = 0; k < NB_CHUNK; k++)
+    {
+        d_mag_taps[k] = (1.0 - NB_MAG_POLE) * pow(NB_MAG_POLE, NB_CHUNK - 1 - k);
+        d_sig_taps[k] = (1.0 - NB_SIG_POLE) * pow(NB_SIG_POLE, NB_CHUNK - 1 - k);
+    }
+    for (int k = 0; k <= NB_CHUNK; k++)
+    {
+        d_mag_pow[k] = pow(NB_MAG_POLE, k);
+        d_sig_pow[k] = pow(NB_SIG_POLE, k);
+    }
 }
 
 rx_nb_cc::~rx_nb_cc()
@@ -70,100 +103,189 @@ int rx_nb_cc::work(int noutput_items,
 {
     const gr_complex *in = (const gr_complex *) input_items[0];
     gr_complex *out = (gr_complex *) output_items[0];
-    int i;
 
-    boost::mutex::scoped_lock lock(d_mutex);
+    d_params.fetch();
+    const rx_nb_params &p = d_params.params();
+    bool nb1_on = p.nb1_on;
+    bool nb2_on = p.nb2_on;
 
-    // copy data into output buffer then perform the processing on that buffer
-    for (i = 0; i < noutput_items; i++)
+    if (!nb1_on && !nb2_on)
     {
-        out[i] = in[i];
+        memcpy(out, in + NB1_DELAY, noutput_items * sizeof(gr_complex));
+        return noutput_items;
     }
 
-    if (d_nb1_on)
+    int nmag = noutput_items + NB1_DELAY;
+    if ((int)d_mag.size() < nmag)
+        d_mag.resize(nmag);
+    volk_32fc_magnitude_32f(&d_mag[0], in, nmag);
+
+    if (nb1_on)
     {
-        process_nb1(out, noutput_items);
+        // NB1 output is the input delayed; d_mag[i] is updated to match out[i]
+        process_nb1(out, in, &d_mag[0], noutput_items, p.thld_nb1);
+        if (nb2_on)
+            process_nb2(out, &d_mag[0], noutput_items, p.thld_nb2);
     }
-    if (d_nb2_on)
+    else
     {
-        process_nb2(out, noutput_items);
+        memcpy(out, in + NB1_DELAY, noutput_items * sizeof(gr_complex));
+        process_nb2(out, &d_mag[NB1_DELAY], noutput_items, p.thld_nb2);
     }
 
     return noutput_items;
 }
 
+/*! \brief Largest value in a chunk of magnitudes. */
+static inline float chunk_max(const float *mag, int n)
+{
+    float max = 0.0;
+
+    for (int k = 0; k < n; k++)
+        max = std::max(max, mag[k]);
+
+    return max;
+}
+
 /*! \brief Perform noise blanker 1 processing.
- *  \param buf The data buffer holding gr_complex samples.
- *  \param num The number of samples in the buffer.
+ *  \param out The output buffer.
+ *  \param in The input buffer including NB1_DELAY samples of history.
+ *  \param mag The magnitudes of \p in. Blanked samples are set to 0.
+ *  \param num The number of output samples.
+ *  \param thld The threshold relative to the average magnitude.
  *
  * Noise blanker 1 is the first noise blanker in the processing chain.
  * It is intended to reduce the effect of impulse type noise.
  *
+ * Each sample is compared against the running average including that
+ * sample, as in DTTSP. Within a chunk the average can not drop below
+ * pole^n times its value at the start of the chunk, so a chunk whose
+ * largest magnitude stays under thld times that bound can not contain a
+ * pulse; it is copied and the average is advanced with one dot product.
+ * Other chunks are processed sample by sample.
+ *
  * FIXME: Needs different constants for higher sample rates?
  */
-void rx_nb_cc::process_nb1(gr_complex *buf, int num)
+void rx_nb_cc::process_nb1(gr_complex *out, const gr_complex *in, float *mag,
+                           int num, float thld)
 {
-    float cmag;
     gr_complex zero(0.0, 0.0);
+    const float *cur = mag + NB1_DELAY;
+    float sum;
+    int i, k, n;
 
-    for (int i = 0; i < num; i++)
+    for (i = 0; i < num; i += NB_CHUNK)
     {
-        cmag = abs(buf[i]);
-        d_delay[d_sigidx] = buf[i];
-        d_avgmag_nb1 = 0.999*d_avgmag_nb1 + 0.001*cmag;
-
-        if ((d_hangtime == 0) && (cmag > (d_thld_nb1*d_avgmag_nb1)))
-            d_hangtime = 7;
+        n = std::min(num - i, (int)NB_CHUNK);
 
-        if (d_hangtime > 0)
+        if ((d_hangtime == 0) &&
+            (chunk_max(cur + i, n) <= thld * d_mag_pow[n] * d_avgmag_nb1))
         {
-            buf[i] = zero;
-            d_hangtime--;
+            volk_32f_x2_dot_prod_32f(&sum, cur + i, &d_mag_taps[NB_CHUNK - n], n);
+            d_avgmag_nb1 = d_mag_pow[n] * d_avgmag_nb1 + sum;
+            memcpy(out + i, in + i, n * sizeof(gr_complex));
+            continue;
         }
-        else
+
+        for (k = i; k < i + n; k++)
         {
-            buf[i] = d_delay[d_delidx];
-        }
+            d_avgmag_nb1 = NB_MAG_POLE * d_avgmag_nb1 + (1.0 - NB_MAG_POLE) * cur[k];
+
+            if ((d_hangtime == 0) && (cur[k] > thld * d_avgmag_nb1))
+                d_hangtime = 7;
 
-        d_sigidx = (d_sigidx + 7) & 7;
-        d_delidx = (d_delidx + 7) & 7;
+            if (d_hangtime > 0)
+            {
+                out[k] = zero;
+                mag[k] = 0.0;
+                d_hangtime--;
+            }
+            else
+            {
+                out[k] = in[k];
+            }
+        }
     }
 }
 
 /*! \brief Perform noise blanker 2 processing.
  *  \param buf The data buffer holding gr_complex samples.
+ *  \param mag The magnitudes of the samples in \p buf.
  *  \param num The number of samples in the buffer.
+ *  \param thld The threshold relative to the average magnitude.
  *
  * Noise blanker 2 is the second noise blanker in the processing chain.
  * It is intended to reduce non-pulse type noise (i.e. longer time constants).
+ * Samples above the threshold are replaced with the average signal, which is
+ * calculated from the original samples. Chunks are skipped using the same
+ * bound as in process_nb1().
  *
  * FIXME: Needs different constants for higher sample rates?
  */
-void rx_nb_cc::process_nb2(gr_complex *buf, int num)
+void rx_nb_cc::process_nb2(gr_complex *buf, const float *mag, int num, float thld)
 {
-    float cmag;
-    gr_complex c1(0.75);
-    gr_complex c2(0.25);
+    gr_complex avg;
+    gr_complex x;
+    float sum;
+    int i, k, n;
 
-    for (int i = 0; i < num; i++)
+    for (i = 0; i < num; i += NB_CHUNK)
     {
-        cmag = abs(buf[i]);
-        d_avgsig = c1*d_avgsig + c2*buf[i];
-        d_avgmag_nb2 = 0.999*d_avgmag_nb2 + 0.001*cmag;
+        n = std::min(num - i, (int)NB_CHUNK);
+
+        if (chunk_max(mag + i, n) <= thld * d_mag_pow[n] * d_avgmag_nb2)
+        {
+            volk_32f_x2_dot_prod_32f(&sum, mag + i, &d_mag_taps[NB_CHUNK - n], n);
+            d_avgmag_nb2 = d_mag_pow[n] * d_avgmag_nb2 + sum;
+            volk_32fc_32f_dot_prod_32fc(&avg, buf + i, &d_sig_taps[NB_CHUNK - n], n);
+            d_avgsig = d_sig_pow[n] * d_avgsig + avg;
+            continue;
+        }
+
+        for (k = i; k < i + n; k++)
+        {
+            x = buf[k];
+            d_avgsig = (float) NB_SIG_POLE * d_avgsig + (float) (1.0 - NB_SIG_POLE) * x;
+            d_avgmag_nb2 = NB_MAG_POLE * d_avgmag_nb2 + (1.0 - NB_MAG_POLE) * mag[k];
 
-        if (cmag > d_thld_nb2*d_avgmag_nb2)
-            buf[i] = d_avgsig;
+            if (mag[k] > thld * d_avgmag_nb2)
+                buf[k] = d_avgsig;
+        }
     }
 }
 
+void rx_nb_cc::set_sample_rate(double sample_rate)
+{
+    param_mailbox<rx_nb_params>::scoped_update p(d_params);
+    p->sample_rate = sample_rate;
+}
+
+void rx_nb_cc::set_nb1_on(bool nb1_on)
+{
+    param_mailbox<rx_nb_params>::scoped_update p(d_params);
+    p->nb1_on = nb1_on;
+}
+
+void rx_nb_cc::set_nb2_on(bool nb2_on)
+{
+    param_mailbox<rx_nb_params>::scoped_update p(d_params);
+    p->nb2_on = nb2_on;
+}
+
 void rx_nb_cc::set_threshold1(float threshold)
 {
     if ((threshold >= 1.0) && (threshold <= 20.0))
-        d_thld_nb1 = threshold;
+    {
+        param_mailbox<rx_nb_params>::scoped_update p(d_params);
+        p->thld_nb1 = threshold;
+    }
 }
 
 void rx_nb_cc::set_threshold2(float threshold)
 {
     if ((threshold >= 0.0) && (threshold <= 15.0))
-        d_thld_nb2 = threshold;
+    {
+        param_mailbox<rx_nb_params>::scoped_update p(d_params);
+        p->thld_nb2 = threshold;
+    }
 }
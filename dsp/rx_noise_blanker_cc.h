@@ -25,7 +25,8 @@
 
 #include <gnuradio/sync_block.h>
 #include <gnuradio/gr_complex.h>
-#include <boost/thread/mutex.hpp>
+#include <vector>
+#include "dsp/param_mailbox.h"
 
 class rx_nb_cc;
 
@@ -43,13 +44,35 @@ typedef boost::shared_ptr<rx_nb_cc> rx_nb_cc_sptr;
 rx_nb_cc_sptr make_rx_nb_cc(double sample_rate=96000.0, float thld1=3.3, float thld2=2.5);
 
 
+/*! \brief Noise blanker parameters handed from the setters to rx_nb_cc::work(). */
+struct rx_nb_params
+{
+    bool   nb1_on;        /*! NB1 status (true/false). */
+    bool   nb2_on;        /*! NB2 status (true/false). */
+    double sample_rate;   /*! Sample rate. */
+    float  thld_nb1;      /*! Threshold for noise blanker 1 (1.0 to 20.0 TBC). */
+    float  thld_nb2;      /*! Threshold for noise blanker 2 (0.0 to 15.0 TBC). */
+};
+
+
 /*! \brief Noise blanker block.
  *  \ingroup DSP
  *
  * This block implements noise blanking filters based on the noise blanker code
  * from DTTSP.
-
  *
+ * The samples are processed in chunks of NB_CHUNK samples. The magnitudes are
+ * calculated for the whole buffer using VOLK. Chunks whose largest magnitude
+ * is below a lower bound of the running average times the threshold can not
+ * contain a pulse; for those the averages are advanced with dot products
+ * against the IIR impulse response. The other chunks use the per-sample
+ * running average, so the blanking decisions are the same as in DTTSP. The
+ * 2 sample delay of NB1 uses the block history instead of a circular delay
+ * line.
+ *
+ * The parameters are passed to work() through a param_mailbox and can be
+ * changed while the block is running. When both blankers are off the block
+ * only copies the input.
  */
 class rx_nb_cc : public gr::sync_block
 {
@@ -65,30 +88,34 @@ public:
              gr_vector_const_void_star &input_items,
              gr_vector_void_star &output_items);
 
-    void set_sample_rate(double sample_rate) { d_sample_rate = sample_rate; }
-    void set_nb1_on(bool nb1_on) { d_nb1_on = nb1_on; }
-    void set_nb2_on(bool nb2_on) { d_nb2_on = nb2_on; }
-    bool get_nb1_on() { return d_nb1_on; }
-    bool get_nb2_on() { return d_nb2_on; }
+    void set_sample_rate(double sample_rate);
+    void set_nb1_on(bool nb1_on);
+    void set_nb2_on(bool nb2_on);
+    bool get_nb1_on() { return d_params.get().nb1_on; }
+    bool get_nb2_on() { return d_params.get().nb2_on; }
     void set_threshold1(float threshold);
     void set_threshold2(float threshold);
 
 private:
-    void process_nb1(gr_complex *buf, int num);
-    void process_nb2(gr_complex *buf, int num);
+    enum { NB_CHUNK = 32 };
+
+    void process_nb1(gr_complex *out, const gr_complex *in, float *mag, int num, float thld);
+    void process_nb2(gr_complex *buf, const float *mag, int num, float thld);
 
 private:
-    boost::mutex  d_mutex;  /*! Used to lock internal data while processing or setting parameters. */
+    param_mailbox<rx_nb_params> d_params;  /*! Current parameters. */
 
-    bool   d_nb1_on;        /*! Current NB1 status (true/false). */
-    bool   d_nb2_on;        /*! Current NB2 status (true/false). */
-    double d_sample_rate;   /*! Current sample rate. */
-    float  d_thld_nb1;      /*! Current threshold for noise blanker 1 (1.0 to 20.0 TBC). */
-    float  d_thld_nb2;      /*! Current threshold for noise blanker 2 (0.0 to 15.0 TBC). */
     float  d_avgmag_nb1;    /*! Average magnitude. */
     float  d_avgmag_nb2;    /*! Average magnitude. */
-    gr_complex d_avgsig, d_delay[8];
-    int    d_delidx, d_sigidx, d_hangtime;   // FIXME: need longer buffer for higher sampel rates?
+    gr_complex d_avgsig;    /*! Average signal used by NB2 to replace pulses. */
+    int    d_hangtime;      /*! Remaining number of samples to blank by NB1. */
+
+    std::vector<float> d_mag;  /*! Magnitude of the input buffer. */
+
+    float  d_mag_taps[NB_CHUNK];       /*! Impulse response of the magnitude averages. */
+    float  d_mag_pow[NB_CHUNK + 1];    /*! Powers of the magnitude average pole. */
+    float  d_sig_taps[NB_CHUNK];       /*! Impulse response of the NB2 signal average. */
+    float  d_sig_pow[NB_CHUNK + 1];    /*! Powers of the NB2 signal average pole. */
 
 };
 
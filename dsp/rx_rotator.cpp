@@ -0,0 +1,96 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <math.h>
+#include <algorithm>
+#include <gnuradio/io_signature.h>
+#include <volk/volk.h>
+#include <dsp/rx_rotator.h>
+
+
+rx_rotator_cc_sptr make_rx_rotator_cc(double sample_rate, double freq)
+{
+    return gnuradio::get_initial_sptr(new rx_rotator_cc(sample_rate, freq));
+}
+
+rx_rotator_cc::rx_rotator_cc(double sample_rate, double freq)
+    : gr::sync_block ("rx_rotator_cc",
+          gr::io_signature::make(1, 1, sizeof(gr_complex)),
+          gr::io_signature::make(1, 1, sizeof(gr_complex))),
+      d_freq(freq),
+      d_sample_rate(sample_rate),
+      d_cur_freq(freq),
+      d_cur_sample_rate(sample_rate),
+      d_phase(1.0f, 0.0f)
+{
+    const int alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
+    set_alignment(std::max(1, alignment_multiple));
+
+    update_phase_incr();
+}
+
+rx_rotator_cc::~rx_rotator_cc()
+{
+}
+
+void rx_rotator_cc::set_freq(double freq)
+{
+    d_freq.store(freq);
+}
+
+void rx_rotator_cc::set_sample_rate(double sample_rate)
+{
+    d_sample_rate.store(sample_rate);
+}
+
+/*! \brief Calculate the phase increment from the current frequency and rate. */
+void rx_rotator_cc::update_phase_incr()
+{
+    double w = 2.0 * M_PI * d_cur_freq / d_cur_sample_rate;
+
+    d_phase_incr = gr_complex(cos(w), sin(w));
+}
+
+int rx_rotator_cc::work(int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items)
+{
+    const gr_complex *in = (const gr_complex *) input_items[0];
+    gr_complex *out = (gr_complex *) output_items[0];
+
+    double freq = d_freq.load(boost::memory_order_relaxed);
+    double rate = d_sample_rate.load(boost::memory_order_relaxed);
+
+    if ((freq != d_cur_freq) || (rate != d_cur_sample_rate))
+    {
+        d_cur_freq = freq;
+        d_cur_sample_rate = rate;
+        update_phase_incr();
+    }
+
+    volk_32fc_s32fc_x2_rotator_32fc(out, in, d_phase_incr, &d_phase, noutput_items);
+
+    /* keep the oscillator amplitude from drifting */
+    d_phase /= std::abs(d_phase);
+
+    return noutput_items;
+}
@@ -0,0 +1,97 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef RX_ROTATOR_H
+#define RX_ROTATOR_H
+
+#include <boost/atomic.hpp>
+#include <gnuradio/sync_block.h>
+
+
+class rx_rotator_cc;
+
+typedef boost::shared_ptr<rx_rotator_cc> rx_rotator_cc_sptr;
+
+
+/*! \brief Return a shared_ptr to a new instance of rx_rotator_cc.
+ *  \param sample_rate The sample rate (Hz).
+ *  \param freq The frequency shift (Hz).
+ *
+ * This is effectively the public constructor. To avoid accidental use
+ * of raw pointers, the rx_rotator_cc constructor is private.
+ * make_rx_rotator_cc is the public interface for creating new instances.
+ */
+rx_rotator_cc_sptr make_rx_rotator_cc(double sample_rate, double freq=0.0);
+
+
+/*! \brief Frequency shifter (complex input and output).
+ *  \ingroup DSP
+ *
+ * This block multiplies the input with a complex exponential, i.e. it
+ * does the same as a sig_source_c feeding a multiply_cc, but in a single
+ * block. The oscillator is a phase accumulator advanced with a complex
+ * multiplication per sample using the VOLK rotator kernel, so there is no
+ * separate oscillator buffer and no extra scheduler hop at the input rate.
+ *
+ * The frequency and sample rate can be changed from any thread while the
+ * flow graph is running. The new values are picked up at the beginning of
+ * the next call to work() without taking any lock and without a phase
+ * discontinuity.
+ */
+class rx_rotator_cc : public gr::sync_block
+{
+    friend rx_rotator_cc_sptr make_rx_rotator_cc(double sample_rate, double freq);
+
+protected:
+    rx_rotator_cc(double sample_rate, double freq);
+
+public:
+    ~rx_rotator_cc();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+    /*! \brief Set the frequency shift in Hz. */
+    void set_freq(double freq);
+
+    /*! \brief Get the frequency shift in Hz. */
+    double get_freq() { return d_freq.load(); }
+
+    /*! \brief Set the sample rate in Hz. */
+    void set_sample_rate(double sample_rate);
+
+private:
+    boost::atomic<double> d_freq;        /*! Requested frequency shift. */
+    boost::atomic<double> d_sample_rate; /*! Requested sample rate. */
+
+    /* work() side */
+    double     d_cur_freq;         /*! Frequency used for d_phase_incr. */
+    double     d_cur_sample_rate;  /*! Sample rate used for d_phase_incr. */
+    gr_complex d_phase;            /*! Current oscillator phase. */
+    gr_complex d_phase_incr;       /*! Phase increment per sample. */
+
+    void update_phase_incr();
+};
+
+
+#endif /* RX_ROTATOR_H */
@@ -0,0 +1,133 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <string.h>
+#include <algorithm>
+#include <gnuradio/io_signature.h>
+#include <dsp/rx_select.h>
+
+
+rx_select_sptr make_rx_select(size_t itemsize, int ninputs, int nchannels)
+{
+    return gnuradio::get_initial_sptr(new rx_select(itemsize, ninputs, nchannels));
+}
+
+rx_select::rx_select(size_t itemsize, int ninputs, int nchannels)
+    : gr::block ("rx_select",
+          gr::io_signature::make(ninputs * nchannels, ninputs * nchannels, itemsize),
+          gr::io_signature::make(nchannels, nchannels, itemsize)),
+      d_itemsize(itemsize),
+      d_ninputs(ninputs),
+      d_nchannels(nchannels),
+      d_input(0)
+{
+
+}
+
+rx_select::~rx_select()
+{
+}
+
+void rx_select::set_input(int input)
+{
+    if ((input >= 0) && (input < d_ninputs))
+        d_input.store(input);
+}
+
+/*! \brief Only the selected input is required to have data. */
+void rx_select::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+{
+    int input = d_input.load(boost::memory_order_relaxed);
+
+    for (unsigned int i = 0; i < ninput_items_required.size(); i++)
+        ninput_items_required[i] = ((int)i / d_nchannels == input) ? noutput_items : 0;
+}
+
+int rx_select::general_work(int noutput_items,
+                               gr_vector_int &ninput_items,
+                               gr_vector_const_void_star &input_items,
+                               gr_vector_void_star &output_items)
+{
+    int input = d_input.load(boost::memory_order_relaxed);
+    int n = noutput_items;
+    int c;
+
+    /* the selection may have changed since forecast() */
+    for (c = 0; c < d_nchannels; c++)
+        n = std::min(n, ninput_items[input * d_nchannels + c]);
+
+    for (c = 0; c < d_nchannels; c++)
+        memcpy(output_items[c], input_items[input * d_nchannels + c],
+               n * d_itemsize);
+
+    for (unsigned int i = 0; i < ninput_items.size(); i++)
+        consume(i, ((int)i / d_nchannels == input) ? n : ninput_items[i]);
+
+    return n;
+}
+
+
+rx_demux_sptr make_rx_demux(size_t itemsize, int noutputs)
+{
+    return gnuradio::get_initial_sptr(new rx_demux(itemsize, noutputs));
+}
+
+rx_demux::rx_demux(size_t itemsize, int noutputs)
+    : gr::block ("rx_demux",
+          gr::io_signature::make(1, 1, itemsize),
+          gr::io_signature::make(noutputs, noutputs, itemsize)),
+      d_itemsize(itemsize),
+      d_noutputs(noutputs),
+      d_output(0)
+{
+
+}
+
+rx_demux::~rx_demux()
+{
+}
+
+void rx_demux::set_output(int output)
+{
+    if ((output >= 0) && (output < d_noutputs))
+        d_output.store(output);
+}
+
+void rx_demux::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+{
+    ninput_items_required[0] = noutput_items;
+}
+
+int rx_demux::general_work(int noutput_items,
+                           gr_vector_int &ninput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items)
+{
+    int output = d_output.load(boost::memory_order_relaxed);
+    int n = std::min(noutput_items, ninput_items[0]);
+
+    memcpy(output_items[output], input_items[0], n * d_itemsize);
+    consume(0, n);
+    produce(output, n);
+
+    return WORK_CALLED_PRODUCE;
+}
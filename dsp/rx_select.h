@@ -0,0 +1,138 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef RX_SELECT_H
+#define RX_SELECT_H
+
+#include <boost/atomic.hpp>
+#include <gnuradio/block.h>
+
+
+class rx_select;
+class rx_demux;
+
+typedef boost::shared_ptr<rx_select> rx_select_sptr;
+typedef boost::shared_ptr<rx_demux> rx_demux_sptr;
+
+
+/*! \brief Return a shared_ptr to a new instance of rx_select.
+ *  \param itemsize The size of a stream item, e.g. sizeof(float).
+ *  \param ninputs Number of selectable inputs.
+ *  \param nchannels Number of streams per input (e.g. 2 for stereo).
+ *
+ * This is effectively the public constructor. To avoid accidental use
+ * of raw pointers, the rx_select constructor is private.
+ * make_rx_select is the public interface for creating new instances.
+ */
+rx_select_sptr make_rx_select(size_t itemsize, int ninputs, int nchannels=1);
+
+
+/*! \brief Lock-free selector for demodulator or filter outputs.
+ *  \ingroup DSP
+ *
+ * The block has ninputs * nchannels input ports and nchannels output
+ * ports. Input port i * nchannels + c belongs to channel c of input i.
+ * Only the selected input is required to have data; it is copied to the
+ * output. Whatever arrives on the other inputs is discarded, so that no
+ * stale samples are left behind when the selection changes.
+ *
+ * Used together with rx_demux, which only feeds the selected demodulator,
+ * this allows keeping several demodulators connected at the same time
+ * while only one of them is running, and switching between them at a
+ * block boundary without locking or reconfiguring the flow graph.
+ */
+class rx_select : public gr::block
+{
+    friend rx_select_sptr make_rx_select(size_t itemsize, int ninputs, int nchannels);
+
+protected:
+    rx_select(size_t itemsize, int ninputs, int nchannels);
+
+public:
+    ~rx_select();
+
+    void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+    int general_work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+
+    /*! \brief Select input. Can be called from any thread. */
+    void set_input(int input);
+
+    /*! \brief Get the currently selected input. */
+    int get_input() { return d_input.load(); }
+
+private:
+    size_t             d_itemsize;  /*! Size of a stream item. */
+    int                d_ninputs;   /*! Number of selectable inputs. */
+    int                d_nchannels; /*! Number of streams per input. */
+    boost::atomic<int> d_input;     /*! Selected input. */
+};
+
+
+/*! \brief Return a shared_ptr to a new instance of rx_demux.
+ *  \param itemsize The size of a stream item, e.g. sizeof(gr_complex).
+ *  \param noutputs Number of outputs.
+ */
+rx_demux_sptr make_rx_demux(size_t itemsize, int noutputs);
+
+
+/*! \brief Lock-free router feeding one of several demodulators or filters.
+ *  \ingroup DSP
+ *
+ * The input is copied to the selected output only. The blocks connected
+ * to the other outputs receive no data and do not run. This is the input
+ * side counterpart of rx_select.
+ */
+class rx_demux : public gr::block
+{
+    friend rx_demux_sptr make_rx_demux(size_t itemsize, int noutputs);
+
+protected:
+    rx_demux(size_t itemsize, int noutputs);
+
+public:
+    ~rx_demux();
+
+    void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+    int general_work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+
+    /*! \brief Select output. Can be called from any thread. */
+    void set_output(int output);
+
+    /*! \brief Get the currently selected output. */
+    int get_output() { return d_output.load(); }
+
+private:
+    size_t             d_itemsize;  /*! Size of a stream item. */
+    int                d_noutputs;  /*! Number of outputs. */
+    boost::atomic<int> d_output;    /*! Selected output. */
+};
+
+
+#endif /* RX_SELECT_H */
@@ -21,6 +21,7 @@
  * Boston, MA 02110-1301, USA.
  */
 #include <math.h>
+#include <algorithm>
 #include <gnuradio/io_signature.h>
 #include <dsp/sniffer_f.h>
 
@@ -43,11 +44,12 @@ sniffer_f::sniffer_f(int buffsize)
     : gr::sync_block ("rx_fft_c",
           gr::io_signature::make(1, 1, sizeof(float)),
           gr::io_signature::make(0, 0, 0)),
+      d_buffsize(0),
       d_minsamp(1000)
 {
 
-    /* allocate circular buffer */
-    d_buffer.set_capacity(buffsize);
+    /* allocate queue */
+    set_buffer_size(buffsize);
 
 }
 
@@ -63,23 +65,18 @@ sniffer_f::~sniffer_f()
  *  \param output_items
  *
  * This method does nothing except dumping the incoming samples into the
- * circular buffer.
+ * queue. Samples that do not fit are dropped.
  */
 int sniffer_f::work(int noutput_items,
                     gr_vector_const_void_star &input_items,
                     gr_vector_void_star &output_items)
 {
-    int i;
     const float *in = (const float *)input_items[0];
 
     (void) output_items;
 
-    boost::mutex::scoped_lock lock(d_mutex);
-
-    /* dump new samples into the buffer */
-    for (i = 0; i < noutput_items; i++) {
-        d_buffer.push_back(in[i]);
-    }
+    /* dump new samples into the queue */
+    d_queue->push(in, noutput_items);
 
     return noutput_items;
 }
@@ -93,9 +90,7 @@ int sniffer_f::work(int noutput_items,
  */
 int  sniffer_f::samples_available()
 {
-    boost::mutex::scoped_lock lock(d_mutex);
-
-    return d_buffer.size();
+    return std::min((unsigned int)d_queue->read_available(), d_buffsize);
 }
 
 /*! \brief Fetch avaialble samples.
@@ -105,20 +100,20 @@ int  sniffer_f::samples_available()
  */
 void sniffer_f::get_samples(float * out, unsigned int &num)
 {
-    boost::mutex::scoped_lock lock(d_mutex);
+    unsigned int avail = d_queue->read_available();
 
-    if (d_buffer.size() < d_minsamp) {
+    if (avail < d_minsamp) {
         /* not enough samples in buffer */
         num = 0;
         return;
     }
 
-    num = d_buffer.size();
-    float *buff = d_buffer.linearize();
-
-    memcpy(out, buff, sizeof(float)*num);
+    /* discard samples older than the newest d_buffsize */
+    while (avail > d_buffsize) {
+        avail -= d_queue->pop(out, std::min(avail - d_buffsize, d_buffsize));
+    }
 
-    d_buffer.clear();
+    num = d_queue->pop(out, avail);
 }
 
 
@@ -127,10 +122,25 @@ void sniffer_f::get_samples(float * out, unsigned int &num)
  */
 void sniffer_f::set_buffer_size(int newsize)
 {
-    boost::mutex::scoped_lock lock(d_mutex);
+    if ((unsigned int)newsize == d_buffsize)
+        return;
+
+    /* only safe while the block is not running, see receiver::start_sniffer() */
+    d_buffsize = newsize;
+    d_queue.reset(new boost::lockfree::spsc_queue<float>(2 * d_buffsize));
+}
+
+
+/*! \brief Discard all samples in the queue.
+ *
+ * Only safe while the block is not running, see receiver::start_sniffer().
+ */
+void sniffer_f::clear()
+{
+    float buf[256];
 
-    //d_buffer.clear();
-    d_buffer.set_capacity(newsize);
+    while (d_queue->pop(buf, 256) > 0)
+        ;
 }
 
 
@@ -141,7 +151,5 @@ void sniffer_f::set_buffer_size(int newsize)
  */
 int  sniffer_f::buffer_size()
 {
-    boost::mutex::scoped_lock lock(d_mutex);
-
-    return d_buffer.capacity();
+    return d_buffsize;
 }
@@ -24,8 +24,8 @@
 #define SNIFFER_F_H
 
 #include <gnuradio/sync_block.h>
-#include <boost/thread/mutex.hpp>
-#include <boost/circular_buffer.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/scoped_ptr.hpp>
 
 
 class sniffer_f;
@@ -51,9 +51,13 @@ sniffer_f_sptr make_sniffer_f(int buffsize=48000);
  * flow graph. For example, a sniffer can be connected to the output of the demodulator
  * and used by data decoders.
  *
- * The class uses a circular buffer for internal storage and if the received samples
- * exceed the buffer size, old samples will be overwritten. The collected samples
- * can be accessed via the get_samples() method.
+ * The class uses a lock-free single-producer / single-consumer queue for internal
+ * storage, so work() never waits for the reader. The queue holds twice the buffer
+ * size; get_samples() returns at most the newest buffer_size() samples and
+ * discards older ones. If the reader falls further behind, new samples are
+ * dropped until it catches up. The collected samples can be accessed via the
+ * get_samples() method, which must only be called from one thread at a time.
+ * Samples left from a previous session are discarded with clear().
  */
 class sniffer_f : public gr::sync_block
 {
@@ -72,7 +76,8 @@ public:
     int  samples_available();
     void get_samples(float * buffer, unsigned int &num);
 
-    void set_buffer_size(int newsize);
+    void set_buffer_size(int newsize);  // only while disconnected
+    void clear();                       // only while disconnected
     int  buffer_size();
 
     void set_min_samples(unsigned int num) {d_minsamp = num;}
@@ -80,8 +85,8 @@ public:
 
 private:
 
-    boost::mutex d_mutex;                   /*! Used to prevent concurrent access to buffer. */
-    boost::circular_buffer<float> d_buffer; /*! buffer to accumulate samples. */
+    boost::scoped_ptr< boost::lockfree::spsc_queue<float> > d_queue; /*! queue to accumulate samples. */
+    unsigned int d_buffsize;                /*! largest number of samples we return. */
     unsigned int d_minsamp;                 /*! smallest number of samples we want to return. */
 
 };
@@ -0,0 +1,121 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <boost/atomic.hpp>
+
+
+/*! \brief Lock-free single-producer / single-consumer triple buffer.
+ *  \ingroup DSP
+ *
+ * Three objects of type T are owned by the buffer: one belongs to the
+ * writer, one to the reader and the third one is the "middle" slot that
+ * is swapped with either side using a single atomic exchange. The writer
+ * fills write_buffer() and calls publish(); the reader calls fetch() and,
+ * if it returns true, uses read_buffer() until the next fetch().
+ *
+ * Neither side ever waits for the other. If the writer publishes faster
+ * than the reader fetches, older objects are simply overwritten so that
+ * the reader always gets the newest complete one.
+ *
+ * Exactly one thread may use the writer interface and exactly one thread
+ * may use the reader interface at any time.
+ */
+template <class T>
+class triple_buffer
+{
+public:
+    /*! \brief Create a new triple buffer.
+     *  \param init Initial value copied into all three slots. Use this to
+     *              preallocate storage so that no allocation is needed later.
+     */
+    explicit triple_buffer(const T &init = T())
+        : d_write(0),
+          d_read(1),
+          d_middle(2)
+    {
+        d_buf[0] = init;
+        d_buf[1] = init;
+        d_buf[2] = init;
+    }
+
+    /*! \brief Object owned by the writer. */
+    T &write_buffer()
+    {
+        return d_buf[d_write];
+    }
+
+    /*! \brief Hand the current write buffer over to the reader.
+     *  \returns true if the previously published object was overwritten
+     *           before the reader fetched it.
+     *
+     * After this call write_buffer() refers to a different object whose
+     * contents are whatever the reader left in it.
+     */
+    bool publish()
+    {
+        unsigned int old = d_middle.exchange(d_write | FRESH, boost::memory_order_acq_rel);
+        d_write = old & INDEX_MASK;
+
+        return (old & FRESH) != 0;
+    }
+
+    /*! \brief Get the newest published object, if any.
+     *  \returns true if read_buffer() now refers to a new object.
+     */
+    bool fetch()
+    {
+        if (!(d_middle.load(boost::memory_order_relaxed) & FRESH))
+            return false;
+
+        unsigned int old = d_middle.exchange(d_read, boost::memory_order_acq_rel);
+        d_read = old & INDEX_MASK;
+
+        return true;
+    }
+
+    /*! \brief Object owned by the reader (last fetched object). */
+    T &read_buffer()
+    {
+        return d_buf[d_read];
+    }
+
+private:
+    enum {
+        INDEX_MASK = 0x3,  /*!< Slot index bits in d_middle. */
+        FRESH      = 0x4   /*!< Middle slot has not been fetched yet. */
+    };
+
+    T            d_buf[3];   /*! The three slots. */
+    unsigned int d_write;    /*! Slot owned by the writer. */
+    unsigned int d_read;     /*! Slot owned by the reader. */
+
+    boost::atomic<unsigned int> d_middle; /*! Middle slot index and FRESH flag. */
+
+    /* not copyable */
+    triple_buffer(const triple_buffer &);
+    triple_buffer &operator=(const triple_buffer &);
+};
+
+#endif /* TRIPLE_BUFFER_H */
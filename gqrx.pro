@@ -77,17 +77,25 @@ SOURCES += \
     applications/gqrx/main.cpp \
     applications/gqrx/mainwindow.cpp \
     applications/gqrx/receiver.cpp \
+    applications/gqrx/spectrum_producer.cpp \
     dsp/afsk1200/cafsk12.cpp \
     dsp/afsk1200/costabf.c \
     dsp/agc_impl.cpp \
-    dsp/correct_iq_cc.cpp \
+    dsp/fft_plan_cache.cpp \
+    dsp/filter/decimator.cpp \
+    dsp/filter/fir_decim.cpp \
+    dsp/hbf_decim.cpp \
+    dsp/iq_condition_cc.cpp \
     dsp/lpf.cpp \
+    dsp/param_mailbox.cpp \
     dsp/resampler_xx.cpp \
     dsp/rx_demod_am.cpp \
     dsp/rx_demod_fm.cpp \
     dsp/rx_fft.cpp \
     dsp/rx_filter.cpp \
     dsp/rx_meter.cpp \
+    dsp/rx_rotator.cpp \
+    dsp/rx_select.cpp \
     dsp/rx_agc_xx.cpp \
     dsp/rx_noise_blanker_cc.cpp \
     dsp/sniffer_f.cpp \
@@ -100,6 +108,7 @@ SOURCES += \
     qtgui/dockaudio.cpp \
     qtgui/dockfft.cpp \
     qtgui/dockiqplayer.cpp \
+    qtgui/dockprofiler.cpp \
     qtgui/dockrxopt.cpp \
     qtgui/freqctrl.cpp \
     qtgui/gain_options.cpp \
@@ -118,13 +127,23 @@ SOURCES += \
 HEADERS += \
     applications/gqrx/mainwindow.h \
     applications/gqrx/receiver.h \
+    applications/gqrx/spectrum_producer.h \
     applications/gqrx/gqrx.h \
     dsp/afsk1200/cafsk12.h \
     dsp/afsk1200/filter.h \
     dsp/afsk1200/filter-i386.h \
     dsp/agc_impl.h \
-    dsp/correct_iq_cc.h \
+    dsp/fft_plan_cache.h \
+    dsp/filter/decimator.h \
+    dsp/filter/filtercoef_hbf_70.h \
+    dsp/filter/filtercoef_hbf_100.h \
+    dsp/filter/filtercoef_hbf_140.h \
+    dsp/filter/fir_decim.h \
+    dsp/filter/fir_decim_coef.h \
+    dsp/hbf_decim.h \
+    dsp/iq_condition_cc.h \
     dsp/lpf.h \
+    dsp/param_mailbox.h \
     dsp/resampler_xx.h \
     dsp/rx_agc_xx.h \
     dsp/rx_demod_am.h \
@@ -132,9 +151,12 @@ HEADERS += \
     dsp/rx_fft.h \
     dsp/rx_filter.h \
     dsp/rx_meter.h \
+    dsp/rx_rotator.h \
+    dsp/rx_select.h \
     dsp/rx_noise_blanker_cc.h \
     dsp/sniffer_f.h \
     dsp/stereo_demod.h \
+    dsp/triple_buffer.h \
     qtgui/afsk1200win.h \
     qtgui/agc_options.h \
     qtgui/audio_options.h \
@@ -143,6 +165,7 @@ HEADERS += \
     qtgui/dockfft.h \
     qtgui/dockinputctl.h \
     qtgui/dockiqplayer.h \
+    qtgui/dockprofiler.h \
     qtgui/dockrxopt.h \
     qtgui/freqctrl.h \
     qtgui/gain_options.h \
@@ -168,6 +191,7 @@ FORMS += \
     qtgui/dockfft.ui \
     qtgui/dockiqplayer.ui \
     qtgui/dockinputctl.ui \
+    qtgui/dockprofiler.ui \
     qtgui/dockrxopt.ui \
     qtgui/gain_options.ui \
     qtgui/ioconfig.ui \
@@ -206,6 +230,8 @@ unix:!macx {
                  gnuradio-filter \
                  gnuradio-fft \
                  gnuradio-osmosdr \
+                 volk \
+                 fftw3f \
                  gnuradio-digital \
                  libdsd
 
@@ -231,6 +257,7 @@ macx {
     LIBS += -lboost_system-mt -lboost_program_options-mt
     LIBS += -lgnuradio-runtime -lgnuradio-pmt -lgnuradio-audio -lgnuradio-analog
     LIBS += -lgnuradio-blocks -lgnuradio-filter -lgnuradio-fft -lgnuradio-osmosdr
+    LIBS += -lvolk -lfftw3f
 
     # portaudio
     contains(AUDIO_BACKEND, portaudio): {
@@ -79,9 +79,13 @@ void DockAudio::setFftRange(quint64 minf, quint64 maxf)
     }
 }
 
-void DockAudio::setNewFttData(double *fftData, int size)
+/*! \brief Set new audio FFT data.
+ *  \param fftData The positive half of the audio spectrum in dBFS.
+ *  \param size The number of points in fftData (half the FFT size).
+ */
+void DockAudio::setNewFttData(float *fftData, int size)
 {
-    ui->audioSpectrum->setNewFttData(fftData, size);
+    ui->audioSpectrum->setNewFttData(fftData, size, true);
 }
 
 /*! \brief Set new audio gain.
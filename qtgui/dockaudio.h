@@ -51,7 +51,7 @@ public:
     ~DockAudio();
 
     void setFftRange(quint64 minf, quint64 maxf);
-    void setNewFttData(double *fftData, int size);
+    void setNewFttData(float *fftData, int size);
     int  fftRate() { return 10; }
 
     void setAudioGain(int gain);
@@ -60,6 +60,8 @@ public:
     void setAudioRecButtonState(bool checked);
     void setAudioPlayButtonState(bool checked);
 
+    QString recDir() const { return rec_dir; }
+
     void setFftColor(QColor color);
     void setFftFill(bool enabled);
 
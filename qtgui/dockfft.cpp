@@ -31,6 +31,7 @@
 #define DEFAULT_FFT_SIZE  2048
 #define DEFAULT_FFT_SPLIT 50
 #define DEFAULT_FFT_AVG   50
+#define DEFAULT_FFT_OVERLAP -1  /* Welch mode off */
 
 
 DockFft::DockFft(QWidget *parent) :
@@ -145,6 +146,43 @@ int DockFft::fftSize()
     return fft_size;
 }
 
+/*! \brief Get current Welch overlap setting.
+ *  \return The overlap in percent, or -1 if Welch mode is off.
+ */
+int DockFft::fftOverlap()
+{
+    bool ok;
+    int overlap;
+    QString strval = ui->fftWelchComboBox->currentText();
+
+    strval.remove(" %");
+    overlap = strval.toInt(&ok, 10);
+
+    if (!ok)
+        overlap = -1;
+
+    return overlap;
+}
+
+/*! \brief Select new Welch overlap in the combo box.
+ *  \param overlap The overlap in percent, or -1 to disable Welch mode.
+ *  \returns The actual overlap selected.
+ */
+int DockFft::setFftOverlap(int overlap)
+{
+    int idx = -1;
+
+    if (overlap < 0)
+        idx = 0;
+    else
+        idx = ui->fftWelchComboBox->findText(QString("%1 %").arg(overlap), Qt::MatchExactly);
+
+    if (idx != -1)
+        ui->fftWelchComboBox->setCurrentIndex(idx);
+
+    return fftOverlap();
+}
+
 /*! \brief Save FFT settings. */
 void DockFft::saveSettings(QSettings *settings)
 {
@@ -172,6 +210,12 @@ void DockFft::saveSettings(QSettings *settings)
     else
         settings->remove("averaging");
 
+    intval = fftOverlap();
+    if (intval != DEFAULT_FFT_OVERLAP)
+        settings->setValue("welch_overlap", intval);
+    else
+        settings->remove("welch_overlap");
+
     if (ui->fftSplitSlider->value() != DEFAULT_FFT_SPLIT)
         settings->setValue("split", ui->fftSplitSlider->value());
     else
@@ -216,6 +260,10 @@ void DockFft::readSettings(QSettings *settings)
     if (conv_ok)
         ui->fftAvgSlider->setValue(intval);
 
+    intval = settings->value("welch_overlap", DEFAULT_FFT_OVERLAP).toInt(&conv_ok);
+    if (conv_ok)
+        setFftOverlap(intval);
+
     intval = settings->value("split", DEFAULT_FFT_SPLIT).toInt(&conv_ok);
     if (conv_ok)
         ui->fftSplitSlider->setValue(intval);
@@ -261,6 +309,15 @@ void DockFft::on_fftAvgSlider_valueChanged(int value)
     emit fftAvgChanged(avg);
 }
 
+/*! \brief Welch mode or overlap changed. */
+void DockFft::on_fftWelchComboBox_currentIndexChanged(const QString & text)
+{
+    int overlap = fftOverlap();
+    Q_UNUSED(text);
+
+    emit fftWelchChanged(overlap >= 0, overlap >= 0 ? 1.0e-2*overlap : 0.0);
+}
+
 void DockFft::on_resetButton_clicked(void)
 {
     emit resetFftZoom();
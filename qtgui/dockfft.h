@@ -45,6 +45,9 @@ public:
     int fftSize();
     int setFftSize(int fft_size);
 
+    int fftOverlap();
+    int setFftOverlap(int overlap);
+
     void saveSettings(QSettings *settings);
     void readSettings(QSettings *settings);
 
@@ -53,6 +56,7 @@ signals:
     void fftRateChanged(int fps);    /*! FFT rate changed. */
     void fftSplitChanged(int pct);   /*! Split between pandapter and waterfall changed. */
     void fftAvgChanged(double gain); /*! FFT video filter gain has changed. */
+    void fftWelchChanged(bool enable, double overlap); /*! Welch averaging mode or overlap changed. */
     void resetFftZoom(void);         /*! FFT zoom reset. */
     void gotoFftCenter(void);        /*! Go to FFT center. */
     void gotoDemodFreq(void);        /*! Center FFT around demodulator frequency. */
@@ -64,6 +68,7 @@ private slots:
     void on_fftRateComboBox_currentIndexChanged(const QString & text);
     void on_fftSplitSlider_valueChanged(int value);
     void on_fftAvgSlider_valueChanged(int value);
+    void on_fftWelchComboBox_currentIndexChanged(const QString & text);
     void on_resetButton_clicked(void);
     void on_centerButton_clicked(void);
     void on_demodButton_clicked(void);
@@ -0,0 +1,164 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <QDateTime>
+#include <QDebug>
+#include <QFileDialog>
+#include <QTableWidgetItem>
+#include <QTextStream>
+#include "dockprofiler.h"
+#include "ui_dockprofiler.h"
+
+
+/*! \brief Format a buffer fullness value, "-" if the block has no such ports. */
+static QString fullnessText(float full)
+{
+    if (full < 0.0f)
+        return QString("-");
+
+    return QString::number(100.0 * full, 'f', 0);
+}
+
+/*! \brief Format a throughput value with a k or M prefix. */
+static QString throughputText(double rate)
+{
+    if (rate >= 1.0e6)
+        return QString("%1 M").arg(rate * 1.0e-6, 0, 'f', 2);
+    else if (rate >= 1.0e3)
+        return QString("%1 k").arg(rate * 1.0e-3, 0, 'f', 1);
+    else
+        return QString::number(rate, 'f', 0);
+}
+
+
+DockProfiler::DockProfiler(QWidget *parent) :
+    QDockWidget(parent),
+    ui(new Ui::DockProfiler)
+{
+    ui->setupUi(this);
+}
+
+DockProfiler::~DockProfiler()
+{
+    if (d_csvFile.isOpen())
+        d_csvFile.close();
+
+    delete ui;
+}
+
+
+/*! \brief Show new performance data.
+ *  \param rows One entry per block.
+ *
+ * If CSV recording is active the data is also appended to the file.
+ */
+void DockProfiler::setRows(const QVector<ProfilerRow> &rows)
+{
+    ui->profTable->setRowCount(rows.size());
+
+    for (int i = 0; i < rows.size(); i++)
+    {
+        QString cells[6];
+        cells[0] = rows[i].name;
+        cells[1] = QString::number(rows[i].workTime, 'f', 1);
+        cells[2] = QString::number(100.0 * rows[i].busy, 'f', 1);
+        cells[3] = throughputText(rows[i].throughput);
+        cells[4] = fullnessText(rows[i].inFull);
+        cells[5] = fullnessText(rows[i].outFull);
+
+        for (int col = 0; col < 6; col++)
+        {
+            QTableWidgetItem *item = ui->profTable->item(i, col);
+            if (!item)
+            {
+                item = new QTableWidgetItem();
+                if (col > 0)
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                ui->profTable->setItem(i, col, item);
+            }
+            item->setText(cells[col]);
+        }
+    }
+
+    if (d_csvFile.isOpen())
+        writeCsv(rows);
+}
+
+/*! \brief Show the parameter mailbox statistics. */
+void DockProfiler::setMailboxStats(quint64 updates, quint64 overwritten, quint64 contention)
+{
+    ui->mboxLabel->setText(tr("Parameter updates: %1  overwritten: %2  contention: %3")
+                           .arg(updates).arg(overwritten).arg(contention));
+}
+
+
+/*! \brief CSV button clicked. Start or stop recording to a CSV file. */
+void DockProfiler::on_csvButton_clicked(bool checked)
+{
+    if (!checked)
+    {
+        qDebug() << "Profiler: stop recording" << d_csvFile.fileName();
+        d_csvFile.close();
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save profiler data"), "",
+                                                    tr("CSV files (*.csv)"));
+
+    if (fileName.isEmpty())
+    {
+        /* user cancelled */
+        ui->csvButton->setChecked(false);
+        return;
+    }
+
+    d_csvFile.setFileName(fileName);
+    if (!d_csvFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        qDebug() << "Profiler: can not open" << fileName;
+        ui->csvButton->setChecked(false);
+        return;
+    }
+
+    if (d_csvFile.size() == 0)
+    {
+        QTextStream out(&d_csvFile);
+        out << "time,block,work_time_us,busy,throughput,in_buf,out_buf\n";
+    }
+
+    qDebug() << "Profiler: recording to" << fileName;
+}
+
+/*! \brief Append one line per block to the CSV file. */
+void DockProfiler::writeCsv(const QVector<ProfilerRow> &rows)
+{
+    QTextStream out(&d_csvFile);
+    QString time = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    for (int i = 0; i < rows.size(); i++)
+    {
+        out << time << ',' << rows[i].name << ','
+            << rows[i].workTime << ',' << rows[i].busy << ','
+            << rows[i].throughput << ','
+            << rows[i].inFull << ',' << rows[i].outFull << '\n';
+    }
+}
@@ -0,0 +1,83 @@
+/* -*- c++ -*- */
+/*
+ * Gqrx SDR: Software defined radio receiver powered by GNU Radio and Qt
+ *           http://gqrx.dk/
+ *
+ * Copyright 2026 Alexandru Csete & contributors.
+ *
+ * Gqrx is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * Gqrx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Gqrx; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef DOCKPROFILER_H
+#define DOCKPROFILER_H
+
+#include <QDockWidget>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+
+namespace Ui {
+    class DockProfiler;
+}
+
+
+/*! \brief Performance data of one block as shown in the profiler. */
+struct ProfilerRow
+{
+    QString name;        /*! Block name. */
+    double  workTime;    /*! Average time per work() call in us. */
+    double  busy;        /*! Fraction of time spent in work(). */
+    double  throughput;  /*! Items per second. */
+    float   inFull;      /*! Input buffer fullness (0 to 1), negative if none. */
+    float   outFull;     /*! Output buffer fullness (0 to 1), negative if none. */
+};
+
+
+/*! \brief Live profiler widget.
+ *
+ * This dock widget shows the work time, load, throughput and buffer
+ * fullness of each block in the receiver flow graph together with the
+ * parameter mailbox statistics. The data is provided periodically by the
+ * main window and can optionally be appended to a CSV file on each update.
+ *
+ * Work time, load and buffer fullness are only available when gqrx is
+ * started with the --profile option, which enables the GNU Radio
+ * performance counters.
+ */
+class DockProfiler : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DockProfiler(QWidget *parent = 0);
+    ~DockProfiler();
+
+    void setRows(const QVector<ProfilerRow> &rows);
+    void setMailboxStats(quint64 updates, quint64 overwritten, quint64 contention);
+    bool isRecording() const { return d_csvFile.isOpen(); }
+
+private slots:
+    void on_csvButton_clicked(bool checked);
+
+private:
+    void writeCsv(const QVector<ProfilerRow> &rows);
+
+private:
+    Ui::DockProfiler *ui;  /*! UI generated by Qt Designer. */
+    QFile   d_csvFile;     /*! CSV file while recording. */
+};
+
+#endif // DOCKPROFILER_H
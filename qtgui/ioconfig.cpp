@@ -161,6 +161,13 @@ CIoConfig::CIoConfig(QSettings *settings, QWidget *parent) :
     // LNB LO
     ui->loSpinBox->setValue(1.0e-6*settings->value("input/lnb_lo", 0.0).toDouble());
 
+    // Input decimation (combo box items are 1, 2, 4, ... 256)
+    int decim = settings->value("input/decimation", 1).toInt();
+    int decim_idx = 0;
+    while ((decim_idx < ui->decimCombo->count() - 1) && ((1 << decim_idx) < decim))
+        decim_idx++;
+    ui->decimCombo->setCurrentIndex(decim_idx);
+
     // Output device
     QString outdev = settings->value("output/device", "").toString();
 
@@ -247,6 +254,12 @@ void CIoConfig::saveConfig()
     if (value)
         m_settings->setValue("input/lnb_lo", value);
 
+    int decim = 1 << ui->decimCombo->currentIndex();
+    if (decim > 1)
+        m_settings->setValue("input/decimation", decim);
+    else
+        m_settings->remove("input/decimation");
+
     bool ok=false;
     int sr = ui->inSrCombo->currentText().toInt(&ok);
     if (ok)
@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <cmath>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QtGlobal>
 
 
@@ -60,17 +61,17 @@ CPlotter::CPlotter(QWidget *parent) :
     for (int i = 0; i < 256; i++)
     {
         if( (i<43) )
-            m_ColorTbl[i].setRgb( 0,0, 255*(i)/43);
+            m_ColorTbl[i] = qRgb( 0,0, 255*(i)/43);
         if( (i>=43) && (i<87) )
-            m_ColorTbl[i].setRgb( 0, 255*(i-43)/43, 255 );
+            m_ColorTbl[i] = qRgb( 0, 255*(i-43)/43, 255 );
         if( (i>=87) && (i<120) )
-            m_ColorTbl[i].setRgb( 0,255, 255-(255*(i-87)/32));
+            m_ColorTbl[i] = qRgb( 0,255, 255-(255*(i-87)/32));
         if( (i>=120) && (i<154) )
-            m_ColorTbl[i].setRgb( (255*(i-120)/33), 255, 0);
+            m_ColorTbl[i] = qRgb( (255*(i-120)/33), 255, 0);
         if( (i>=154) && (i<217) )
-            m_ColorTbl[i].setRgb( 255, 255 - (255*(i-154)/62), 0);
+            m_ColorTbl[i] = qRgb( 255, 255 - (255*(i-154)/62), 0);
         if( (i>=217)  )
-            m_ColorTbl[i].setRgb( 255, 0, 128*(i-217)/38);
+            m_ColorTbl[i] = qRgb( 255, 0, 128*(i-217)/38);
     }
 
     m_FftCenter = 0;
@@ -95,6 +96,11 @@ CPlotter::CPlotter(QWidget *parent) :
     m_Span = 96000;
     m_SampleFreq = 96000;
 
+    m_fftData = 0;
+    m_wfData = 0;
+    m_fftDataSize = 0;
+    m_fftHalf = false;
+
     m_HorDivs = 12;
     m_VerDivs = 6;
     m_MaxdB = 0;
@@ -107,7 +113,19 @@ CPlotter::CPlotter(QWidget *parent) :
     m_DrawOverlay = true;
     m_2DPixmap = QPixmap(0,0);
     m_OverlayPixmap = QPixmap(0,0);
-    m_WaterfallPixmap = QPixmap(0,0);
+    m_WaterfallImage = QImage();
+    m_WaterfallOffset = 0;
+    m_DrawTime = 0;
+    m_WaterfallTime = 0;
+    m_PaintTime = 0;
+    m_TimedFrames = 0;
+    m_TblPlotWidth = -1;
+    m_TblFftSize = -1;
+    m_TblBinMin = 0;
+    m_TblBinMax = 0;
+    m_TblLargeFft = false;
+    m_TblXmin = 0;
+    m_TblXmax = 0;
     m_Size = QSize(0,0);
     m_GrabPosition = 0;
     m_Percent2DScreen = 50;	//percent of screen used for 2D display
@@ -545,14 +563,21 @@ void CPlotter::resizeEvent(QResizeEvent* )
         m_2DPixmap.fill(Qt::black);
 
         int height = (100-m_Percent2DScreen)*m_Size.height()/100;
-        if (m_WaterfallPixmap.isNull()) {
-            m_WaterfallPixmap = QPixmap(m_Size.width(), height);
-            m_WaterfallPixmap.fill(Qt::black);
+        if (m_WaterfallImage.isNull()) {
+            m_WaterfallImage = QImage(m_Size.width(), height, QImage::Format_RGB32);
+            m_WaterfallImage.fill(Qt::black);
         } else {
-            m_WaterfallPixmap = m_WaterfallPixmap.scaled(m_Size.width(), height,
-                                                         Qt::IgnoreAspectRatio,
-                                                         Qt::SmoothTransformation);
+            // unwrap the ring buffer before scaling
+            QImage linear(m_WaterfallImage.size(), QImage::Format_RGB32);
+            QPainter painter(&linear);
+            drawWaterfall(painter, 0);
+            painter.end();
+            m_WaterfallImage = linear.scaled(m_Size.width(), height,
+                                             Qt::IgnoreAspectRatio,
+                                             Qt::SmoothTransformation)
+                               .convertToFormat(QImage::Format_RGB32);
         }
+        m_WaterfallOffset = 0;
     }
     drawOverlay();
 }
@@ -562,15 +587,44 @@ void CPlotter::resizeEvent(QResizeEvent* )
 //////////////////////////////////////////////////////////////////////
 void CPlotter::paintEvent(QPaintEvent *)
 {
+#ifndef QT_NO_DEBUG_OUTPUT
+    QElapsedTimer timer;
+    timer.start();
+#endif
     QPainter painter(this);
 
     painter.drawPixmap(0,0,m_2DPixmap);
-    painter.drawPixmap(0, m_Percent2DScreen*m_Size.height()/100,m_WaterfallPixmap);
+    drawWaterfall(painter, m_Percent2DScreen*m_Size.height()/100);
+#ifndef QT_NO_DEBUG_OUTPUT
+    painter.end();
+    m_PaintTime += timer.nsecsElapsed();
+#endif
     //tell interface that its ok to signal a new line of fft data
     //m_pSdrInterface->ScreenUpdateDone();
     return;
 }
 
+/*! \brief Draw the waterfall ring buffer.
+ *  \param painter The painter to draw with.
+ *  \param y The y position of the top (newest) line.
+ *
+ * The newest line is at row m_WaterfallOffset of m_WaterfallImage and
+ * older lines follow below, wrapping around at the end of the image.
+ */
+void CPlotter::drawWaterfall(QPainter &painter, int y)
+{
+    int w = m_WaterfallImage.width();
+    int h = m_WaterfallImage.height();
+    int off = m_WaterfallOffset;
+
+    if ((w == 0) || (h == 0))
+        return;
+
+    painter.drawImage(QPoint(0, y), m_WaterfallImage, QRect(0, off, w, h - off));
+    if (off > 0)
+        painter.drawImage(QPoint(0, y + h - off), m_WaterfallImage, QRect(0, 0, w, off));
+}
+
 
 //////////////////////////////////////////////////////////////////////
 // Called to update spectrum data for displaying on the screen
@@ -593,17 +647,23 @@ void CPlotter::draw()
     if (!m_Running)
         return;
 
+#ifndef QT_NO_DEBUG_OUTPUT
+    QElapsedTimer timer;
+    timer.start();
+#endif
+
     // get/draw the waterfall
-    w = m_WaterfallPixmap.width();
-    h = m_WaterfallPixmap.height();
+    w = m_WaterfallImage.width();
+    h = m_WaterfallImage.height();
 
-    // no need to draw if pixmap is invisible
-    if ((w != 0) || (h != 0))
+    // no need to draw if image is invisible
+    if ((w != 0) && (h != 0))
     {
-        // move current data down one line(must do before attaching a QPainter object)
-        m_WaterfallPixmap.scroll(0,1,0,0, w, h);
+        // the new line replaces the oldest one, i.e. the ring buffer moves
+        // up one row instead of scrolling the whole image down
+        m_WaterfallOffset = (m_WaterfallOffset + h - 1) % h;
+        QRgb *line = (QRgb *) m_WaterfallImage.scanLine(m_WaterfallOffset);
 
-        QPainter painter1(&m_WaterfallPixmap);
         // get scaled FFT data
         getScreenIntegerFFTData(255, qMin(w, MAX_SCREENSIZE),
                                 m_MaxdB, m_MindB,
@@ -612,19 +672,19 @@ void CPlotter::draw()
                                 m_wfData, m_fftbuf,
                                 &xmin, &xmax);
 
-        // draw new line of fft data at top of waterfall bitmap
-        painter1.setPen(QColor(0, 0, 0));
+        // write new line of fft data directly into the scanline
         for (i = 0; i < xmin; i++)
-            painter1.drawPoint(i,0);
-        for (i = xmax; i < w; i++)
-            painter1.drawPoint(i,0);
+            line[i] = qRgb(0, 0, 0);
         for (i = xmin; i < xmax; i++)
-        {
-            painter1.setPen(m_ColorTbl[ 255-m_fftbuf[i] ]);
-            painter1.drawPoint(i,0);
-        }
+            line[i] = m_ColorTbl[ 255-m_fftbuf[i] ];
+        for (i = xmax; i < w; i++)
+            line[i] = qRgb(0, 0, 0);
     }
 
+#ifndef QT_NO_DEBUG_OUTPUT
+    m_WaterfallTime += timer.nsecsElapsed();
+#endif
+
     // get/draw the 2D spectrum
     w = m_2DPixmap.width();
     h = m_2DPixmap.height();
@@ -688,18 +748,36 @@ void CPlotter::draw()
         }
     }
 
+#ifndef QT_NO_DEBUG_OUTPUT
+    m_DrawTime += timer.nsecsElapsed();
+    if (++m_TimedFrames == 100)
+    {
+        qDebug() << QString("Plotter frame time: draw %1 ms (waterfall %2 ms), paint %3 ms")
+                    .arg(m_DrawTime * 1.e-8, 0, 'f', 3)
+                    .arg(m_WaterfallTime * 1.e-8, 0, 'f', 3)
+                    .arg(m_PaintTime * 1.e-8, 0, 'f', 3);
+        m_DrawTime = 0;
+        m_WaterfallTime = 0;
+        m_PaintTime = 0;
+        m_TimedFrames = 0;
+    }
+#endif
+
     // trigger a new paintEvent
     update();
 }
 
 /*! \brief Set new FFT data.
  *  \param fftData Pointer to the new FFT data (same data for pandapter and waterfall).
- *  \param size The FFT size.
+ *  \param size The number of points in fftData.
+ *  \param half If true, fftData only contains the positive frequencies of
+ *              a real FFT, i.e. size points from 0 to half the sample rate.
+ *              Otherwise it contains a complete, FFT-shifted spectrum.
  *
  * When FFT data is set using this method, the same data will be used for bith the
  * pandapter and the waterfall.
  */
-void CPlotter::setNewFttData(double *fftData, int size)
+void CPlotter::setNewFttData(float *fftData, int size, bool half)
 {
 
     /** FIXME **/
@@ -709,6 +787,7 @@ void CPlotter::setNewFttData(double *fftData, int size)
     m_wfData = fftData;
     m_fftData = fftData;
     m_fftDataSize = size;
+    m_fftHalf = half;
 
     draw();
 }
@@ -722,7 +801,7 @@ void CPlotter::setNewFttData(double *fftData, int size)
  * waterfall.
  */
 
-void CPlotter::setNewFttData(double *fftData, double *wfData, int size)
+void CPlotter::setNewFttData(float *fftData, float *wfData, int size)
 {
 
     /** FIXME **/
@@ -732,108 +811,149 @@ void CPlotter::setNewFttData(double *fftData, double *wfData, int size)
     m_wfData = wfData;
     m_fftData = fftData;
     m_fftDataSize = size;
+    m_fftHalf = false;
 
     draw();
 }
 
-void CPlotter::getScreenIntegerFFTData(qint32 plotHeight, qint32 plotWidth,
-                                       double maxdB, double mindB,
-                                       qint64 startFreq, qint64 stopFreq,
-                                       double *inBuf, qint32 *outBuf,
-                                       int *xmin, int *xmax)
+/*! \brief Update the cached FFT bin to screen translation table.
+ *  \param plotWidth The plot width in pixels.
+ *  \param fftSize The number of FFT bins.
+ *  \param binMin The FFT bin at the left edge of the plot.
+ *  \param binMax The FFT bin at the right edge of the plot.
+ *
+ * The table only depends on the arguments, which in turn capture the plot
+ * size, span, FFT center, sample rate and FFT size. It is therefore only
+ * rebuilt when one of those changes, i.e. on resize, zoom or FFT size
+ * change, and not for every frame.
+ *
+ * If there are more FFT bins than pixels, entry x is the first FFT bin
+ * mapped to pixel x, so pixel x covers bins [tbl[x], tbl[x+1]). Otherwise
+ * entry x is the FFT bin shown at pixel x.
+ */
+void CPlotter::updateTranslateTbl(qint32 plotWidth, qint32 fftSize,
+                                  qint32 binMin, qint32 binMax)
 {
-    qint32 i;
-    qint32 y;
-    qint32 x;
-    qint32 ymax = 10000;
-    qint32 xprev = -1;
-    qint32 minbin, maxbin;
-    qint32 m_BinMin, m_BinMax;
-    qint32 m_FFTSize = m_fftDataSize;
-    double *m_pFFTAveBuf = inBuf;
-    double  dBGainFactor = ((double)plotHeight)/abs(maxdB-mindB);
-    qint32* m_pTranslateTbl = new qint32[qMax(m_FFTSize, plotWidth)];
+    qint32 i, x;
 
-    /** FIXME: qint64 -> qint32 **/
-    m_BinMin = (qint32)((double)startFreq*(double)m_FFTSize/m_SampleFreq);
-    m_BinMin += (m_FFTSize/2);
-    m_BinMax = (qint32)((double)stopFreq*(double)m_FFTSize/m_SampleFreq);
-    m_BinMax += (m_FFTSize/2);
-
-    minbin = m_BinMin < 0 ? 0 : m_BinMin;
-    if (m_BinMin > m_FFTSize)
-        m_BinMin = m_FFTSize - 1;
-    if (m_BinMax <= m_BinMin)
-        m_BinMax = m_BinMin + 1;
-    maxbin = m_BinMax < m_FFTSize ? m_BinMax : m_FFTSize;
-    bool largeFft = (m_BinMax-m_BinMin) > plotWidth; // true if more fft point than plot points
-
-    if (largeFft)
+    if ((plotWidth == m_TblPlotWidth) && (fftSize == m_TblFftSize) &&
+        (binMin == m_TblBinMin) && (binMax == m_TblBinMax))
+        return;
+
+    m_TblPlotWidth = plotWidth;
+    m_TblFftSize = fftSize;
+    m_TblBinMin = binMin;
+    m_TblBinMax = binMax;
+
+    qint32 minbin = binMin < 0 ? 0 : binMin;
+    qint32 maxbin = binMax < fftSize ? binMax : fftSize;
+
+    m_TblLargeFft = (binMax - binMin) > plotWidth;
+    m_TranslateTbl.resize(plotWidth + 1);
+
+    if (m_TblLargeFft)
     {
         // more FFT points than plot points
+        x = 0;
         for (i = minbin; i < maxbin; i++)
-            m_pTranslateTbl[i] = ((i-m_BinMin)*plotWidth) / (m_BinMax - m_BinMin);
-        *xmin = m_pTranslateTbl[minbin];
-        *xmax = m_pTranslateTbl[maxbin - 1];
+        {
+            qint32 px = (qint32)(((qint64)(i - binMin)*plotWidth) / (binMax - binMin));
+            while (x <= px)
+                m_TranslateTbl[x++] = i;
+        }
+        while (x <= plotWidth)
+            m_TranslateTbl[x++] = maxbin;
+
+        if (minbin < maxbin)
+        {
+            m_TblXmin = (qint32)(((qint64)(minbin - binMin)*plotWidth) / (binMax - binMin));
+            m_TblXmax = (qint32)(((qint64)(maxbin - 1 - binMin)*plotWidth) / (binMax - binMin));
+        }
+        else
+        {
+            m_TblXmin = 0;
+            m_TblXmax = 0;
+        }
     }
     else
     {
         // more plot points than FFT points
-        for (i = 0; i < plotWidth; i++)
-            m_pTranslateTbl[i] = m_BinMin + (i*(m_BinMax - m_BinMin)) / plotWidth;
-        *xmin = 0;
-        *xmax = plotWidth;
+        for (x = 0; x < plotWidth; x++)
+        {
+            i = binMin + (qint32)(((qint64)x*(binMax - binMin)) / plotWidth);
+            m_TranslateTbl[x] = qBound(0, i, fftSize - 1);
+        }
+        m_TblXmin = 0;
+        m_TblXmax = plotWidth;
     }
+}
+
+void CPlotter::getScreenIntegerFFTData(qint32 plotHeight, qint32 plotWidth,
+                                       double maxdB, double mindB,
+                                       qint64 startFreq, qint64 stopFreq,
+                                       float *inBuf, qint32 *outBuf,
+                                       int *xmin, int *xmax)
+{
+    qint32 i;
+    qint32 x;
+    qint32 y;
+    qint32 binMin, binMax;
+    qint32 fftSize = m_fftDataSize;
+    float  dBGainFactor = ((float)plotHeight)/abs(maxdB-mindB);
+    float  fmaxdB = maxdB;
+    float  pmax;
+
+    // bins per sample rate and index of the 0 Hz bin
+    qint32 binsPerRate = m_fftHalf ? 2*fftSize : fftSize;
+    qint32 binOffset = m_fftHalf ? 0 : fftSize/2;
+
+    /** FIXME: qint64 -> qint32 **/
+    binMin = (qint32)((double)startFreq*(double)binsPerRate/m_SampleFreq);
+    binMin += binOffset;
+    binMax = (qint32)((double)stopFreq*(double)binsPerRate/m_SampleFreq);
+    binMax += binOffset;
+
+    if (binMin > fftSize)
+        binMin = fftSize - 1;
+    if (binMax <= binMin)
+        binMax = binMin + 1;
 
-    if (largeFft)
+    updateTranslateTbl(plotWidth, fftSize, binMin, binMax);
+
+    const qint32 *tbl = &m_TranslateTbl[0];
+
+    *xmin = m_TblXmin;
+    *xmax = m_TblXmax;
+
+    if (m_TblLargeFft)
     {
-        // more FFT points than plot points
-        for (i = minbin; i < maxbin; i++ )
+        // more FFT points than plot points: keep the max value of the
+        // bins mapped to each pixel
+        for (x = m_TblXmin; x <= m_TblXmax; x++)
         {
-            y = (qint32)(dBGainFactor*(maxdB-m_pFFTAveBuf[i]));
-
-            if (y > plotHeight)
-                y = plotHeight;
-            else if (y < 0)
-                y = 0;
+            qint32 first = tbl[x];
+            qint32 last = tbl[x+1];
 
-            x = m_pTranslateTbl[i];	//get fft bin to plot x coordinate transform
+            if (first >= last)
+                continue;
 
-            if (x == xprev)   // still mappped to same fft bin coordinate
-            {
-                if (y < ymax) // store only the max value
-                {
-                    outBuf[x] = y;
-                    ymax = y;
-                }
+            pmax = inBuf[first];
+            for (i = first + 1; i < last; i++)
+                pmax = inBuf[i] > pmax ? inBuf[i] : pmax;
 
-            }
-            else
-            {
-                outBuf[x] = y;
-                xprev = x;
-                ymax = y;
-            }
+            y = (qint32)(dBGainFactor*(fmaxdB - pmax));
+            outBuf[x] = qBound(0, y, plotHeight);
         }
     }
     else
     {
         // more plot points than FFT points
-        for (x = 0; x < plotWidth; x++ )
+        for (x = 0; x < plotWidth; x++)
         {
-            i = m_pTranslateTbl[x]; // get plot to fft bin coordinate transform
-            y = (qint32)(dBGainFactor*(maxdB-m_pFFTAveBuf[i]));
-
-            if (y > plotHeight)
-                y = plotHeight;
-            else if (y < 0)
-                y = 0;
-
-            outBuf[x] = y;
+            y = (qint32)(dBGainFactor*(fmaxdB - inBuf[tbl[x]]));
+            outBuf[x] = qBound(0, y, plotHeight);
         }
     }
-
-    delete [] m_pTranslateTbl;
 }
 
 
@@ -35,8 +35,8 @@ public:
         resizeEvent(NULL);
     }
 
-    void setNewFttData(double *fftData, int size);
-    void setNewFttData(double *fftData, double *wfData, int size);
+    void setNewFttData(float *fftData, int size, bool half=false);
+    void setNewFttData(float *fftData, float *wfData, int size);
 
     void setCenterFreq(quint64 f);
     void setFreqUnits(qint32 unit) { m_FreqUnits = unit; }
@@ -60,6 +60,11 @@ public:
         m_DemodHiCutFreq = HiCut;
         drawOverlay();
     }
+    void getHiLowCutFrequencies(int *LowCut, int *HiCut)
+    {
+        *LowCut = m_DemodLowCutFreq;
+        *HiCut = m_DemodHiCutFreq;
+    }
 
     void setDemodRanges(int FLowCmin, int FLowCmax, int FHiCmin, int FHiCmax, bool symetric);
 
@@ -138,6 +143,7 @@ private:
         XAXIS
     };
     void drawOverlay();
+    void drawWaterfall(QPainter &painter, int y);
     void makeFrequencyStrs();
     int xFromFreq(qint64 freq);
     qint64 freqFromX(int x);
@@ -148,13 +154,25 @@ private:
     void getScreenIntegerFFTData(qint32 plotHeight, qint32 plotWidth,
                                  double maxdB, double mindB,
                                  qint64 startFreq, qint64 stopFreq,
-                                 double *inBuf, qint32 *outBuf,
+                                 float *inBuf, qint32 *outBuf,
                                  qint32 *maxbin, qint32 *minbin);
+    void updateTranslateTbl(qint32 plotWidth, qint32 fftSize,
+                            qint32 binMin, qint32 binMax);
 
     qint32 m_fftbuf[MAX_SCREENSIZE];
-    double *m_fftData;     /*! pointer to incoming FFT data */
-    double *m_wfData;
+
+    std::vector<qint32> m_TranslateTbl; /*! Cached FFT bin <-> pixel translation table. */
+    qint32  m_TblPlotWidth;    /*! Plot width m_TranslateTbl was built for. */
+    qint32  m_TblFftSize;      /*! FFT size m_TranslateTbl was built for. */
+    qint32  m_TblBinMin;       /*! FFT bin at left edge m_TranslateTbl was built for. */
+    qint32  m_TblBinMax;       /*! FFT bin at right edge m_TranslateTbl was built for. */
+    bool    m_TblLargeFft;     /*! More FFT bins than pixels. */
+    qint32  m_TblXmin;         /*! First pixel with FFT data. */
+    qint32  m_TblXmax;         /*! Last pixel with FFT data. */
+    float  *m_fftData;     /*! pointer to incoming FFT data */
+    float  *m_wfData;
     int     m_fftDataSize;
+    bool    m_fftHalf;         /*! FFT data is the 0..fs/2 half of a real FFT. */
 
     int m_XAxisYCenter;
     int m_YAxisWidth;
@@ -162,8 +180,13 @@ private:
     eCapturetype m_CursorCaptured;
     QPixmap m_2DPixmap;
     QPixmap m_OverlayPixmap;
-    QPixmap m_WaterfallPixmap;
-    QColor m_ColorTbl[256];
+    QImage  m_WaterfallImage;   /*!< Waterfall ring buffer. */
+    int     m_WaterfallOffset;  /*!< Row of the newest line in m_WaterfallImage. */
+    qint64  m_DrawTime;         /*!< Time spent in draw() since the last report in ns. */
+    qint64  m_WaterfallTime;    /*!< Part of m_DrawTime spent on the waterfall in ns. */
+    qint64  m_PaintTime;        /*!< Time spent in paintEvent() since the last report in ns. */
+    int     m_TimedFrames;      /*!< Frames drawn since the last report. */
+    QRgb    m_ColorTbl[256];
     QSize m_Size;
     QString m_Str;
     QString m_HDivText[HORZ_DIVS_MAX+1];
@@ -27,6 +27,17 @@
 #define PREF_AUDIO_RATE 48000.0
 #define QPSK_QUAD_RATE  36000.0
 
+/* Lowest rate the half-band decimator may go down to. This leaves the
+ * arbitrary resampler with a small fractional step while keeping the
+ * half-band transition bands well outside the channel. */
+#define MIN_DECIM_RATE  (4.0 * PREF_QUAD_RATE)
+
+/* Inputs of the demodulator selector */
+#define SEL_SSB 0
+#define SEL_AM  1
+#define SEL_FM  2
+#define SEL_NUM 3
+
 nbrx_sptr make_nbrx(float quad_rate, float audio_rate)
 {
     return gnuradio::get_initial_sptr(new nbrx(quad_rate, audio_rate));
@@ -36,6 +47,7 @@ nbrx::nbrx(float quad_rate, float audio_rate)
     : receiver_base_cf("NBRX"),
       d_running(false),
       d_quad_rate(quad_rate),
+      d_decim(1),
       d_audio_rate(audio_rate),
       d_demod(NBRX_DEMOD_FM)
 {
@@ -51,6 +63,9 @@ nbrx::nbrx(float quad_rate, float audio_rate)
     demod_ssb = gr::blocks::complex_to_real::make(1);
     demod_fm = make_rx_demod_fm(PREF_QUAD_RATE, PREF_AUDIO_RATE, 5000.0, 75.0e-6);
     demod_am = make_rx_demod_am(PREF_QUAD_RATE, PREF_AUDIO_RATE, true);
+    demod_demux = make_rx_demux(sizeof(gr_complex), SEL_NUM);
+    demod_sel = make_rx_select(sizeof(float), SEL_NUM);
+    select_demod(SEL_FM);
     demod_qpsk = make_rx_demod_qpsk(2,0.75,0.03,0.05,0.05,0.05, QPSK_QUAD_RATE);
     audio_rr = make_resampler_ff(d_audio_rate/PREF_AUDIO_RATE);
     audio_rr_dsd = make_resampler_ff(PREF_AUDIO_RATE/8000);
@@ -59,14 +74,13 @@ nbrx::nbrx(float quad_rate, float audio_rate)
     float_to_char = gr::blocks::float_to_char::make(1,1.0);
     shout_streamer = make_shoutstreamer();
 
-    connect(self(), 0, iq_resamp, 0);
+    connect_iq_decim(d_quad_rate, false);
     connect(iq_resamp, 0, nb, 0);
     connect(nb, 0, filter, 0);
     connect(filter, 0, meter, 0);
     connect(filter, 0, sql, 0);
     connect(sql, 0, agc, 0);
-    connect(agc, 0, demod_fm, 0);
-    connect(demod_fm, 0, audio_rr, 0);
+    connect_demods();
     connect(audio_rr, 0, self(), 0); // left  channel
     connect(audio_rr, 0, self(), 1); // right channel
     // FIXME: we only need audio_rr when audio_rate != PREF_AUDIO_RATE
@@ -99,20 +113,131 @@ void nbrx::set_quad_rate(float quad_rate)
 #ifndef QT_NO_DEBUG_OUTPUT
         std::cout << "Changing NB_RX quad rate: "  << d_quad_rate << " -> " << quad_rate << std::endl;
 #endif
+        prepare_quad_rate(quad_rate);
         d_quad_rate = quad_rate;
         lock();
-        iq_resamp->set_rate(PREF_QUAD_RATE/d_quad_rate);
-        //FIXME: leaks like a sieve
-        iq_resamp_qpsk = make_resampler_cc(QPSK_QUAD_RATE/quad_rate);
+        connect_iq_decim(d_quad_rate, true);
         unlock();
     }
 }
 
+/*! \brief Get the half-band decimation to use for an input rate. */
+static unsigned int iq_decimation(float quad_rate)
+{
+    unsigned int decim = 1;
+
+    while ((quad_rate / (2 * decim) >= MIN_DECIM_RATE) && (2 * decim <= MAX_DECIMATION))
+        decim *= 2;
+
+    return decim;
+}
+
+/*! \brief Create the half-band decimator for a new input rate in advance. */
+void nbrx::prepare_quad_rate(float quad_rate)
+{
+    unsigned int decim = iq_decimation(quad_rate);
+
+    if ((decim > 1) && (decim != d_decim) &&
+        (!next_decim || next_decim->get_decim() != decim))
+        next_decim = make_hbf_decim(decim);
+}
+
+/*! \brief Get the block feeding the baseband resamplers. */
+gr::basic_block_sptr nbrx::iq_output()
+{
+    if (d_decim > 1)
+        return iq_decim;
+    else
+        return self();
+}
+
+/*! \brief Set up the front end for a new input rate.
+ *  \param quad_rate The input sample rate.
+ *  \param reconnect Whether the front end is already connected.
+ *
+ * The input is first decimated by the largest power of two that keeps the
+ * rate at or above MIN_DECIM_RATE using the half-band decimator, and the
+ * arbitrary resamplers only do the remaining fractional step. The caller
+ * must hold the lock when the flow graph is running.
+ */
+void nbrx::connect_iq_decim(float quad_rate, bool reconnect)
+{
+    resampler_cc_sptr resamp = (d_demod == NBRX_DEMOD_QPSK) ? iq_resamp_qpsk : iq_resamp;
+    unsigned int decim = iq_decimation(quad_rate);
+
+    if (reconnect)
+    {
+        disconnect(iq_output(), 0, resamp, 0);
+        if (d_decim > 1)
+            disconnect(self(), 0, iq_decim, 0);
+    }
+
+    if (decim != d_decim)
+    {
+        iq_decim.reset();
+        if (decim > 1)
+        {
+            /* use the decimator from prepare_quad_rate() if possible */
+            if (next_decim && next_decim->get_decim() == decim)
+                iq_decim = next_decim;
+            else
+                iq_decim = make_hbf_decim(decim);
+        }
+        d_decim = decim;
+    }
+    next_decim.reset();
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    std::cout << "NB_RX decimation: " << d_decim << std::endl;
+#endif
+
+    iq_resamp->set_rate(PREF_QUAD_RATE * d_decim / quad_rate);
+    iq_resamp_qpsk->set_rate(QPSK_QUAD_RATE * d_decim / quad_rate);
+
+    if (d_decim > 1)
+        connect(self(), 0, iq_decim, 0);
+    connect(iq_output(), 0, resamp, 0);
+}
+
 void nbrx::set_audio_rate(float audio_rate)
 {
     (void) audio_rate;
 }
 
+/*! \brief Append the blocks connected for the current demodulator. */
+void nbrx::get_blocks(std::vector<gr::basic_block_sptr> &blocks)
+{
+    if (d_decim > 1)
+        blocks.push_back(iq_decim);
+
+    if (d_demod == NBRX_DEMOD_QPSK)
+    {
+        blocks.push_back(iq_resamp_qpsk);
+        blocks.push_back(filter_qpsk->get_filter_block());
+        blocks.push_back(meter);
+        blocks.push_back(sql);
+        return;
+    }
+
+    blocks.push_back(iq_resamp);
+    blocks.push_back(nb);
+    blocks.push_back(filter->get_filter_block());
+    blocks.push_back(meter);
+    blocks.push_back(sql);
+    blocks.push_back(agc);
+    blocks.push_back(demod_demux);
+    blocks.push_back(demod_ssb);
+    blocks.push_back(demod_sel);
+    blocks.push_back(audio_rr);
+
+    if (d_demod == NBRX_DEMOD_DSD)
+    {
+        blocks.push_back(gain_dsd);
+        blocks.push_back(dsd);
+        blocks.push_back(audio_rr_dsd);
+    }
+}
+
 void nbrx::set_filter(double low, double high, double tw)
 {
     filter->set_param(low, high, tw);
@@ -127,6 +252,11 @@ float nbrx::get_signal_level(bool dbfs)
 
 }
 
+/*! \brief Enable or disable a noise blanker.
+ *
+ * The blanker stays in the flow graph and copies its input while both
+ * blankers are off, so toggling it never locks the flow graph.
+ */
 void nbrx::set_nb_on(int nbid, bool on)
 {
     if (nbid == 1)
@@ -183,9 +313,55 @@ void nbrx::set_agc_manual_gain(int gain)
     agc->set_manual_gain(gain);
 }
 
+/*! \brief Route the AGC output through one of the analog demodulators.
+ *
+ * The selector is switched first so that it starts discarding what is
+ * left in the previous demodulator, then the input is routed to the new
+ * one. The other demodulators receive no data and do not run.
+ */
+void nbrx::select_demod(int sel)
+{
+    demod_sel->set_input(sel);
+    demod_demux->set_output(sel);
+}
+
+/*! \brief Connect AGC -> router -> demodulators -> selector -> audio resampler. */
+void nbrx::connect_demods()
+{
+    connect(agc, 0, demod_demux, 0);
+    connect(demod_demux, SEL_SSB, demod_ssb, 0);
+    connect(demod_demux, SEL_AM, demod_am, 0);
+    connect(demod_demux, SEL_FM, demod_fm, 0);
+    connect(demod_ssb, 0, demod_sel, SEL_SSB);
+    connect(demod_am, 0, demod_sel, SEL_AM);
+    connect(demod_fm, 0, demod_sel, SEL_FM);
+    connect(demod_sel, 0, audio_rr, 0);
+}
+
+/*! \brief Disconnect the analog demodulators, see connect_demods(). */
+void nbrx::disconnect_demods()
+{
+    disconnect(agc, 0, demod_demux, 0);
+    disconnect(demod_demux, SEL_SSB, demod_ssb, 0);
+    disconnect(demod_demux, SEL_AM, demod_am, 0);
+    disconnect(demod_demux, SEL_FM, demod_fm, 0);
+    disconnect(demod_ssb, 0, demod_sel, SEL_SSB);
+    disconnect(demod_am, 0, demod_sel, SEL_AM);
+    disconnect(demod_fm, 0, demod_sel, SEL_FM);
+    disconnect(demod_sel, 0, audio_rr, 0);
+}
+
+/*! \brief Select demodulator.
+ *
+ * The SSB, AM and FM demodulators are always connected between a router
+ * and a selector, see select_demod(). Switching between them does not lock
+ * or reconfigure the flow graph, and only the selected one is running. QPSK and DSD use different rates
+ * and topology and still require the graph to be locked and rewired.
+ */
 void nbrx::set_demod(int rx_demod)
 {
     nbrx_demod current_demod = d_demod;
+    bool rewire;
 
     /* check if new demodulator selection is valid */
     if ((rx_demod < NBRX_DEMOD_NONE) || (rx_demod > NBRX_DEMOD_DSD))
@@ -196,32 +372,19 @@ void nbrx::set_demod(int rx_demod)
         return;
     }
 
+    rewire = (current_demod == NBRX_DEMOD_QPSK) || (current_demod == NBRX_DEMOD_DSD) ||
+             (rx_demod == NBRX_DEMOD_QPSK) || (rx_demod == NBRX_DEMOD_DSD);
+
     /* lock graph while we reconfigure */
-    lock();
+    if (rewire)
+        lock();
 
-    /* disconnect current demodulator */
+    /* go back to the analog topology */
     switch (current_demod) {
 
-    default:
-    case NBRX_DEMOD_NONE: /** FIXME! **/
-    case NBRX_DEMOD_SSB:
-        disconnect(agc, 0, demod_ssb, 0);
-        disconnect(demod_ssb, 0, audio_rr, 0);
-        break;
-
-    case NBRX_DEMOD_AM:
-        disconnect(agc, 0, demod_am, 0);
-        disconnect(demod_am, 0, audio_rr, 0);
-        break;
-
-    case NBRX_DEMOD_FM:
-        disconnect(agc, 0, demod_fm, 0);
-        disconnect(demod_fm, 0, audio_rr, 0);
-        break;
-
     case NBRX_DEMOD_QPSK:
-        disconnect(self(), 0, iq_resamp_qpsk, 0);
-        connect(self(), 0, iq_resamp, 0);
+        disconnect(iq_output(), 0, iq_resamp_qpsk, 0);
+        connect(iq_output(), 0, iq_resamp, 0);
         disconnect(iq_resamp_qpsk, 0, filter_qpsk, 0);
         disconnect(filter_qpsk, 0, sql, 0);
         disconnect(filter_qpsk, 0, meter, 0);
@@ -229,17 +392,16 @@ void nbrx::set_demod(int rx_demod)
         disconnect(demod_qpsk, 0, self(), 0);
         disconnect(demod_qpsk, 0, self(), 1);
         connect(iq_resamp, 0, nb, 0);
-        connect(sql, 0, agc, 0);
         connect(nb, 0, filter, 0);
+        connect(sql, 0, agc, 0);
         connect(filter, 0, sql, 0);
         connect(filter, 0, meter, 0);
+        connect_demods();
         connect(audio_rr,0 ,self(), 0);
         connect(audio_rr,0 ,self(), 1);
         break;
 
     case NBRX_DEMOD_DSD:
-        disconnect(agc, 0, demod_fm, 0);
-        disconnect(demod_fm, 0, audio_rr, 0);
         disconnect(audio_rr, 0, gain_dsd, 0);
         disconnect(audio_rr_dsd, 0, self(), 0);
         disconnect(audio_rr_dsd, 0, self(), 1);
@@ -248,6 +410,9 @@ void nbrx::set_demod(int rx_demod)
         connect(audio_rr,0 ,self(), 0);
         connect(audio_rr,0 ,self(), 1);
         break;
+
+    default:
+        break;
     }
 
     switch (rx_demod) {
@@ -255,32 +420,31 @@ void nbrx::set_demod(int rx_demod)
     case NBRX_DEMOD_NONE: /** FIXME! **/
     case NBRX_DEMOD_SSB:
         d_demod = NBRX_DEMOD_SSB;
-        connect(agc, 0, demod_ssb, 0);
-        connect(demod_ssb, 0, audio_rr, 0);
+        select_demod(SEL_SSB);
         break;
 
     case NBRX_DEMOD_AM:
         d_demod = NBRX_DEMOD_AM;
-        connect(agc, 0, demod_am, 0);
-        connect(demod_am, 0, audio_rr, 0);
+        select_demod(SEL_AM);
         break;
 
     case NBRX_DEMOD_FM:
         d_demod = NBRX_DEMOD_FM;
-        connect(agc, 0, demod_fm, 0);
-        connect(demod_fm, 0, audio_rr, 0);
+        select_demod(SEL_FM);
         break;
+
     case NBRX_DEMOD_QPSK:
         d_demod = NBRX_DEMOD_QPSK;
+        disconnect(iq_resamp, 0, nb, 0);
         disconnect(nb, 0, filter, 0);
         disconnect(filter, 0, sql, 0);
         disconnect(filter, 0, meter, 0);
         disconnect(audio_rr, 0 ,self(), 0);
         disconnect(audio_rr, 0 ,self(), 1);
         disconnect(sql, 0, agc, 0);
-        disconnect(self(), 0, iq_resamp, 0);
-        disconnect(iq_resamp, 0, nb, 0);
-        connect(self(), 0, iq_resamp_qpsk, 0);
+        disconnect_demods();
+        disconnect(iq_output(), 0, iq_resamp, 0);
+        connect(iq_output(), 0, iq_resamp_qpsk, 0);
         connect(iq_resamp_qpsk, 0, filter_qpsk, 0);
         connect(filter_qpsk, 0, sql, 0);
         connect(filter_qpsk, 0, meter, 0);
@@ -291,8 +455,7 @@ void nbrx::set_demod(int rx_demod)
 
     case NBRX_DEMOD_DSD:
         d_demod = NBRX_DEMOD_DSD;
-        connect(agc, 0, demod_fm, 0);
-        connect(demod_fm, 0, audio_rr, 0);
+        select_demod(SEL_FM);
         disconnect(audio_rr, 0 ,self(), 0);
         disconnect(audio_rr, 0 ,self(), 1);
         connect(audio_rr, 0, gain_dsd, 0);
@@ -303,15 +466,15 @@ void nbrx::set_demod(int rx_demod)
         break;
 
     default:
-        /* use FMN */  
+        /* use FMN */
         d_demod = NBRX_DEMOD_FM;
-        connect(agc, 0, demod_fm, 0);
-        connect(demod_fm, 0, audio_rr, 0);
+        select_demod(SEL_FM);
         break;
     }
 
     /* continue processing */
-    unlock();
+    if (rewire)
+        unlock();
 }
 
 void nbrx::set_fm_maxdev(float maxdev_hz)
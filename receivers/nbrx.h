@@ -27,6 +27,7 @@
 #include <gnuradio/blocks/complex_to_real.h>
 #include <gnuradio/blocks/float_to_char.h>
 #include "receivers/receiver_base.h"
+#include "dsp/hbf_decim.h"
 #include "dsp/rx_noise_blanker_cc.h"
 #include "dsp/rx_filter.h"
 #include "dsp/rx_meter.h"
@@ -34,6 +35,7 @@
 #include "dsp/rx_demod_fm.h"
 #include "dsp/rx_demod_am.h"
 #include "dsp/rx_demod_qpsk.h"
+#include "dsp/rx_select.h"
 #include "dsp/shoutstreamer.h"
 //#include "dsp/resampler_ff.h"
 #include "dsp/resampler_xx.h"
@@ -74,7 +76,9 @@ public:
     bool start();
     bool stop();
 
+    void prepare_quad_rate(float quad_rate);
     void set_quad_rate(float quad_rate);
+    void get_blocks(std::vector<gr::basic_block_sptr> &blocks);
     void set_audio_rate(float audio_rate);
 
     void set_filter(double low, double high, double tw);
@@ -114,10 +118,13 @@ public:
 private:
     bool   d_running;          /*!< Whether receiver is running or not. */
     float  d_quad_rate;        /*!< Input sample rate. */
+    unsigned int d_decim;      /*!< Half-band decimation ahead of the resamplers. */
     int    d_audio_rate;       /*!< Audio output rate. */
 
     nbrx_demod                d_demod;    /*!< Current demodulator. */
 
+    hbf_decim_sptr            iq_decim;    /*!< Half-band decimator (if d_decim > 1). */
+    hbf_decim_sptr            next_decim;  /*!< Decimator prepared by prepare_quad_rate(). */
     resampler_cc_sptr         iq_resamp;   /*!< Baseband resampler. */
     rx_filter_sptr            filter;  /*!< Non-translating bandpass filter.*/
 
@@ -128,6 +135,8 @@ private:
     gr::blocks::complex_to_real::sptr   demod_ssb;  /*!< SSB demodulator. */
     rx_demod_fm_sptr          demod_fm;   /*!< FM demodulator. */
     rx_demod_am_sptr          demod_am;   /*!< AM demodulator. */
+    rx_demux_sptr             demod_demux; /*!< Feeds the SSB, AM or FM demodulator. */
+    rx_select_sptr            demod_sel;  /*!< Selects SSB, AM or FM output. */
     rx_demod_qpsk_sptr        demod_qpsk;
     resampler_ff_sptr         audio_rr;   /*!< Audio resampler. */
     rx_filter_sptr            filter_qpsk;  /*!< Non-translating bandpass filter.*/
@@ -137,6 +146,12 @@ private:
     resampler_cc_sptr         iq_resamp_qpsk;   /*!< Baseband resampler. */
     shoutstreamer_sptr        shout_streamer;
     gr::blocks::float_to_char::sptr float_to_char;
+
+    gr::basic_block_sptr iq_output();
+    void connect_iq_decim(float quad_rate, bool reconnect);
+    void select_demod(int sel);
+    void connect_demods();
+    void disconnect_demods();
 };
 
 #endif // NBRX_H
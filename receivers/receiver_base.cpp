@@ -42,6 +42,16 @@ receiver_base_cf::~receiver_base_cf()
 
 }
 
+void receiver_base_cf::prepare_quad_rate(float quad_rate)
+{
+    (void) quad_rate;
+}
+
+void receiver_base_cf::get_blocks(std::vector<gr::basic_block_sptr> &blocks)
+{
+    (void) blocks;
+}
+
 
 bool receiver_base_cf::has_nb()
 {
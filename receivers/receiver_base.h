@@ -23,6 +23,7 @@
 #ifndef RECEIVER_BASE_H
 #define RECEIVER_BASE_H
 
+#include <vector>
 #include <gnuradio/hier_block2.h>
 
 
@@ -54,6 +55,21 @@ public:
     virtual void set_quad_rate(float quad_rate) = 0;
     virtual void set_audio_rate(float audio_rate) = 0;
 
+    /*! \brief Prepare for a new input rate.
+     *
+     * Called before the flow graph is locked for set_quad_rate() so that
+     * expensive preparations (e.g. creating blocks or designing filters)
+     * do not happen while the graph is stopped.
+     */
+    virtual void prepare_quad_rate(float quad_rate);
+
+    /*! \brief Append the blocks of this receiver to a list.
+     *
+     * Used for performance monitoring. Only blocks that are currently
+     * connected are added; blocks inside nested hier blocks may be omitted.
+     */
+    virtual void get_blocks(std::vector<gr::basic_block_sptr> &blocks);
+
     virtual void set_filter(double low, double high, double tw) = 0;
 
     virtual float get_signal_level(bool dbfs) = 0;
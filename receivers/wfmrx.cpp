@@ -48,6 +48,8 @@ wfmrx::wfmrx(float quad_rate, float audio_rate)
     midle_rr = make_resampler_ff(PREF_MIDLE_RATE/PREF_QUAD_RATE);
     stereo = make_stereo_demod(PREF_MIDLE_RATE, d_audio_rate, true);
     mono   = make_stereo_demod(PREF_MIDLE_RATE, d_audio_rate, false);
+    demod_demux = make_rx_demux(sizeof(float), 2);
+    demod_sel = make_rx_select(sizeof(float), 2, 2);
 
     connect(self(), 0, iq_resamp, 0);
     connect(iq_resamp, 0, filter, 0);
@@ -55,9 +57,15 @@ wfmrx::wfmrx(float quad_rate, float audio_rate)
     connect(filter, 0, sql, 0);
     connect(sql, 0, demod_fm, 0);
     connect(demod_fm, 0, midle_rr, 0);
-    connect(midle_rr, 0, mono, 0);
-    connect(mono, 0, self(), 0); // left  channel
-    connect(mono, 1, self(), 1); // right channel
+    connect(midle_rr, 0, demod_demux, 0);
+    connect(demod_demux, 0, mono, 0);
+    connect(demod_demux, 1, stereo, 0);
+    connect(mono, 0, demod_sel, 0);
+    connect(mono, 1, demod_sel, 1);
+    connect(stereo, 0, demod_sel, 2);
+    connect(stereo, 1, demod_sel, 3);
+    connect(demod_sel, 0, self(), 0); // left  channel
+    connect(demod_sel, 1, self(), 1); // right channel
 }
 
 wfmrx::~wfmrx()
@@ -98,6 +106,18 @@ void wfmrx::set_audio_rate(float audio_rate)
     (void) audio_rate;
 }
 
+/*! \brief Append the blocks of the receiver chain. */
+void wfmrx::get_blocks(std::vector<gr::basic_block_sptr> &blocks)
+{
+    blocks.push_back(iq_resamp);
+    blocks.push_back(filter->get_filter_block());
+    blocks.push_back(meter);
+    blocks.push_back(sql);
+    blocks.push_back(midle_rr);
+    blocks.push_back(demod_demux);
+    blocks.push_back(demod_sel);
+}
+
 void wfmrx::set_filter(double low, double high, double tw)
 {
     filter->set_param(low, high, tw);
@@ -172,6 +192,12 @@ void nbrx::set_agc_manual_gain(int gain)
 }
 */
 
+/*! \brief Select mono or stereo demodulator.
+ *
+ * Both demodulators are always connected between a router and a selector,
+ * so switching does not lock or reconfigure the flow graph. Only the
+ * selected demodulator receives data and runs.
+ */
 void wfmrx::set_demod(int demod)
 {
     /* check if new demodulator selection is valid */
@@ -183,45 +209,20 @@ void wfmrx::set_demod(int demod)
         return;
     }
 
-    /* lock graph while we reconfigure */
-    lock();
-
-    /* disconnect current demodulator */
-    switch (d_demod) {
-
-    case WFMRX_DEMOD_MONO:
-    default:
-        disconnect(midle_rr, 0, mono, 0);
-        disconnect(mono, 0, self(), 0); // left  channel
-        disconnect(mono, 1, self(), 1); // right channel
-        break;
-
-    case WFMRX_DEMOD_STEREO:
-    case WFMRX_DEMOD_STEREO_UKW: /** FIXME! **/
-        disconnect(midle_rr, 0, stereo, 0);
-        disconnect(stereo, 0, self(), 0); // left  channel
-        disconnect(stereo, 1, self(), 1); // right channel
-    }
-
     switch (demod) {
 
     case WFMRX_DEMOD_MONO:
     default:
-        connect(midle_rr, 0, mono, 0);
-        connect(mono, 0, self(), 0); // left  channel
-        connect(mono, 1, self(), 1); // right channel
+        demod_sel->set_input(0);
+        demod_demux->set_output(0);
         break;
 
     case WFMRX_DEMOD_STEREO:
     case WFMRX_DEMOD_STEREO_UKW: /** FIXME! **/
-        connect(midle_rr, 0, stereo, 0);
-        connect(stereo, 0, self(), 0); // left  channel
-        connect(stereo, 1, self(), 1); // right channel
+        demod_sel->set_input(1);
+        demod_demux->set_output(1);
     }
     d_demod = (wfmrx_demod) demod;
-
-    /* continue processing */
-    unlock();
 }
 
 void wfmrx::set_fm_maxdev(float maxdev_hz)
@@ -29,6 +29,7 @@
 #include "dsp/rx_noise_blanker_cc.h"
 #include "dsp/rx_filter.h"
 #include "dsp/rx_meter.h"
+#include "dsp/rx_select.h"
 #include "dsp/rx_demod_fm.h"
 #include "dsp/stereo_demod.h"
 #include "dsp/resampler_xx.h"
@@ -64,6 +65,7 @@ public:
 
     void set_quad_rate(float quad_rate);
     void set_audio_rate(float audio_rate);
+    void get_blocks(std::vector<gr::basic_block_sptr> &blocks);
 
     void set_filter(double low, double high, double tw);
 
@@ -111,6 +113,8 @@ private:
     resampler_ff_sptr         midle_rr;  /*!< Resampler. */
     stereo_demod_sptr         stereo;    /*!< FM stereo demodulator. */
     stereo_demod_sptr         mono;      /*!< FM stereo demodulator OFF. */
+    rx_demux_sptr             demod_demux; /*!< Feeds mono or stereo demodulator. */
+    rx_select_sptr            demod_sel; /*!< Selects mono or stereo output. */
 };
 
 #endif // WFMRX_H